@@ -0,0 +1,143 @@
+/**
+ * @file blend_bench.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * Micro-benchmark of the alpha blending kernels
+ * Compares each kernel, straight and premultiplied, with the previous float blending loop
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "PixelOps.hpp"
+
+//==============================================================================
+// Reference implementation
+
+/* Float blending loop previously used by Renderer::DrawSprite */
+static void BlendRowFloat(unsigned int *dst, const unsigned int *src, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        unsigned int bmpColor = src[i];
+        unsigned int *pixel = dst+i;
+
+        float alpha = (float)((bmpColor & 0xff000000) >> 24)/255.f;
+
+        float ar = (float)((*pixel & 0xff0000) >> 16);
+        float ag = (float)((*pixel & 0xff00) >> 8);
+        float ab = (float)(*pixel & 0xff);
+
+        float br = (float)((bmpColor & 0xff0000) >> 16);
+        float bg = (float)((bmpColor & 0xff00) >> 8);
+        float bb = (float)(bmpColor & 0xff);
+
+        unsigned char r = (unsigned char)((1-alpha)*ar + alpha*br);
+        unsigned char g = (unsigned char)((1-alpha)*ag + alpha*bg);
+        unsigned char b = (unsigned char)((1-alpha)*ab + alpha*bb);
+
+        *pixel = b | (g << 8) | (r << 16);
+    }
+}
+
+//==============================================================================
+// Benchmark
+
+static const int kWidth = 1200;
+static const int kHeight = 720;
+static const int kFrames = 200;
+
+/* Returns the biggest channel difference between two pixels */
+static int ChannelError(unsigned int a, unsigned int b)
+{
+    int error = 0;
+    for (int shift = 0; shift < 24; shift += 8)
+    {
+        int d = (int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff);
+        if (d < 0) d = -d;
+        if (d > error) error = d;
+    }
+    return error;
+}
+
+/* Returns the biggest channel error of a blended frame against the expected one */
+static int FrameError(const std::vector<unsigned int> &dst, const std::vector<unsigned int> &expected)
+{
+    int error = 0;
+    for (int i = 0; i < kWidth*kHeight; i++)
+    {
+        int e = ChannelError(dst[i], expected[i]);
+        if (e > error) error = e;
+    }
+    return error;
+}
+
+/* Blends a full frame kFrames times. Returns the time per frame in ms */
+static double TimeBlend(BlendRowFunc blend, std::vector<unsigned int> &dst, const std::vector<unsigned int> &src)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int f = 0; f < kFrames; f++)
+    {
+        for (int y = 0; y < kHeight; y++)
+            blend(dst.data() + y*kWidth, src.data() + y*kWidth, kWidth);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end-start).count()/kFrames;
+}
+
+int main()
+{
+    std::vector<unsigned int> src(kWidth*kHeight);
+    std::vector<unsigned int> background(kWidth*kHeight);
+    srand(42);
+    for (int i = 0; i < kWidth*kHeight; i++)
+    {
+        src[i] = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
+        background[i] = (((unsigned int)rand() << 16) ^ (unsigned int)rand()) & 0xffffff;
+    }
+
+    std::vector<unsigned int> premultiplied(kWidth*kHeight);
+    for (int i = 0; i < kWidth*kHeight; i++)
+        premultiplied[i] = PremultiplyPixel(src[i]);
+
+    std::vector<unsigned int> expected = background;
+    BlendRowFloat(expected.data(), src.data(), kWidth*kHeight);
+
+    std::vector<unsigned int> dst = background;
+    double reference = TimeBlend(BlendRowFloat, dst, src);
+    printf("%-8s %8.3f ms/frame\n", "Float", reference);
+
+    int result = 0;
+    for (int k = 0; k < kKernelCount; k++)
+    {
+        PixelKernel kernel = (PixelKernel)k;
+        if (kernel == kKernelAVX2 && !CpuHasAvx2()) continue;
+        if (kernel == kKernelSSE2 && !CpuHasSse2()) continue;
+
+        BlendRowFunc blend = GetBlendRow(kernel);
+        dst = background;
+        blend(dst.data(), src.data(), kWidth*kHeight);
+        int error = FrameError(dst, expected);
+
+        dst = background;
+        double time = TimeBlend(blend, dst, src);
+        printf("%-8s %8.3f ms/frame  x%.2f  max error %d\n",
+            PixelKernelName(kernel), time, reference/time, error);
+        if (error > 1) result = 1;
+
+        blend = GetBlendRowPremultiplied(kernel);
+        dst = background;
+        blend(dst.data(), premultiplied.data(), kWidth*kHeight);
+        error = FrameError(dst, expected);
+
+        dst = background;
+        time = TimeBlend(blend, dst, premultiplied);
+        printf("%-8s %8.3f ms/frame  x%.2f  max error %d (premultiplied)\n",
+            PixelKernelName(kernel), time, reference/time, error);
+        if (error > 1) result = 1;
+    }
+
+    return result;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file fill_bench.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * Micro-benchmark of the fill kernels
+ * Compares full buffer clears and rect fills with the previous fill loops
+ * at 720p, 1080p and 4K
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "PixelOps.hpp"
+
+//==============================================================================
+// Reference implementation
+
+/* Fill loop previously used by Renderer::ClearScreen and Renderer::DrawRect */
+static void FillLoop(unsigned int *pixels, int width, int xmin, int ymin, int xmax, int ymax, unsigned int color)
+{
+    for (int y = ymin; y < ymax; y++)
+    {
+        unsigned int *pixel = pixels + y*width + xmin;
+        for (int x = xmin; x < xmax; x++)
+        {
+            *pixel++ = color;
+        }
+    }
+}
+
+//==============================================================================
+// Benchmark
+
+static const int kFrames = 100;
+static const int kRectCount = 500;
+
+// A buffer resolution
+struct Resolution
+{
+    const char *name;
+    int width, height;
+};
+
+// A rect filled each frame
+struct FillRect
+{
+    int xmin, ymin, xmax, ymax;
+};
+
+/* Fills a rect with a fill kernel, one row at a time */
+static void FillKernel(FillRowFunc fill, unsigned int *pixels, int width, const FillRect &r, unsigned int color)
+{
+    unsigned int *pixel = pixels + r.ymin*width + r.xmin;
+    for (int y = r.ymin; y < r.ymax; y++, pixel += width)
+        fill(pixel, color, r.xmax-r.xmin);
+}
+
+/* Returns the time in ms per frame of a clear, or of kRectCount rect fills */
+static double TimeFill(FillRowFunc fill, bool stream, std::vector<unsigned int> &pixels,
+    const Resolution &res, const std::vector<FillRect> &rects)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int f = 0; f < kFrames; f++)
+    {
+        for (const FillRect &r : rects)
+        {
+            if (fill)
+                FillKernel(fill, pixels.data(), res.width, r, (unsigned int)f);
+            else
+                FillLoop(pixels.data(), res.width, r.xmin, r.ymin, r.xmax, r.ymax, (unsigned int)f);
+        }
+        if (stream)
+            FillFence();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end-start).count()/kFrames;
+}
+
+/* Prints the timings of every kernel for a list of rects */
+static void Run(const char *test, const Resolution &res, const std::vector<FillRect> &rects, bool withStream)
+{
+    std::vector<unsigned int> pixels(res.width*res.height);
+
+    double reference = TimeFill(nullptr, false, pixels, res, rects);
+    printf("%-6s %-6s %-16s %8.3f ms/frame\n", res.name, test, "Loop", reference);
+
+    for (int k = 0; k < kKernelCount; k++)
+    {
+        PixelKernel kernel = (PixelKernel)k;
+        if (kernel == kKernelAVX2 && !CpuHasAvx2()) continue;
+        if (kernel == kKernelSSE2 && !CpuHasSse2()) continue;
+
+        double time = TimeFill(GetFillRow(kernel), false, pixels, res, rects);
+        printf("%-6s %-6s %-16s %8.3f ms/frame  x%.2f\n", res.name, test,
+            PixelKernelName(kernel), time, reference/time);
+
+        if (!withStream || kernel == kKernelScalar) continue;
+
+        char name[32];
+        snprintf(name, sizeof(name), "%s stream", PixelKernelName(kernel));
+        time = TimeFill(GetFillRowStream(kernel), true, pixels, res, rects);
+        printf("%-6s %-6s %-16s %8.3f ms/frame  x%.2f\n", res.name, test, name, time, reference/time);
+    }
+}
+
+int main()
+{
+    Resolution resolutions[3] = {
+        {"720p", 1280, 720},
+        {"1080p", 1920, 1080},
+        {"4K", 3840, 2160},
+    };
+
+    srand(42);
+    for (const Resolution &res : resolutions)
+    {
+        std::vector<FillRect> clear = {{0, 0, res.width, res.height}};
+        Run("clear", res, clear, true);
+
+        std::vector<FillRect> rects;
+        for (int i = 0; i < kRectCount; i++)
+        {
+            int w = 4 + rand()%(res.width/8);
+            int h = 4 + rand()%(res.height/8);
+            int x = rand()%(res.width-w);
+            int y = rand()%(res.height-h);
+            rects.push_back({x, y, x+w, y+h});
+        }
+        Run("rects", res, rects, false);
+    }
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file frame_bench.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * Frame time benchmark of the whole game
+ * Runs Game::Update and Renderer::Update offscreen for a number of frames, with scripted
+ * input and a fixed frame time, and prints the p50 and p99 time of each phase of a frame
+ */
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "Headless.hpp"
+#include "Renderer.hpp"
+#include "Game.hpp"
+
+//==============================================================================
+// Scripted input
+
+/* Sets the buttons of a frame. The same frame index always gives the same input */
+static void ScriptInput(Input &input, int frame)
+{
+    // Runs right then left for a second each, jumps every 45 frames and shoots every other frame
+    bool right = (frame/60) % 2 == 0;
+    input.buttons[kButtonRight].ProcessState(right);
+    input.buttons[kButtonLeft].ProcessState(!right);
+    input.buttons[kButtonUp].ProcessState(frame % 45 == 0);
+    input.buttons[kButtonSpace].ProcessState(frame % 2 == 0);
+}
+
+//==============================================================================
+// Benchmark
+
+// The phases of a frame
+enum Phase
+{
+    kPhaseClear,
+    kPhaseGame,
+    kPhaseSprites,
+    kPhaseText,
+    kPhaseRaster,
+    kPhasePresent,
+    kPhaseFrame,
+
+    kPhaseCount
+};
+
+static const char *kPhaseNames[kPhaseCount] = {
+    "clear", "game logic", "sprites", "text", "raster", "present", "frame"
+};
+
+/* Returns the time elapsed since start in ms */
+static float ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+/* Returns the value under which lie percent % of the samples */
+static float Percentile(std::vector<float> samples, int percent)
+{
+    if (samples.empty()) return 0.f;
+    std::sort(samples.begin(), samples.end());
+    size_t index = std::min(samples.size()-1, samples.size()*percent/100);
+    return samples[index];
+}
+
+/* Returns the value of an integer argument, or fallback if it isn't given */
+static int IntArgument(int argc, char **argv, const char *name, int fallback)
+{
+    for (int i = 1; i+1 < argc; i++)
+    {
+        if (!strcmp(argv[i], name))
+            return atoi(argv[i+1]);
+    }
+    return fallback;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = IntArgument(argc, argv, "--frames", 600);
+    int equations = IntArgument(argc, argv, "--equations", 4);
+    int bullets = IntArgument(argc, argv, "--bullets", 1);
+    int threads = IntArgument(argc, argv, "--threads", 0);
+    int width = IntArgument(argc, argv, "--width", 1200);
+    int height = IntArgument(argc, argv, "--height", 720);
+
+    // The game picks the equations' rows with rand
+    srand(42);
+
+    HeadlessWindow win(width, height);
+    win.SetFrameLimit(frames);
+    Renderer renderer(win.GetBuffer());
+    if (threads > 0)
+        renderer.EnableBinning(threads);
+    Game game;
+    game.Init(&renderer, equations, bullets);
+
+    std::vector<float> samples[kPhaseCount];
+    int commands = 0;
+    while (win.IsRunning())
+    {
+        auto frameStart = std::chrono::steady_clock::now();
+        renderer.ClearScreen(0x242C66);
+
+        win.HandleMessages();
+        ScriptInput(win.input, win.GetFrameCount());
+        renderer.Update(win.GetFt());
+
+        auto start = std::chrono::steady_clock::now();
+        game.Update(&renderer, &win.input, win.GetFt());
+        float gameTime = ElapsedMs(start);
+        renderer.EndFrame();
+
+        start = std::chrono::steady_clock::now();
+        win.ProcessFrame(renderer.GetDirtyRects());
+        float presentTime = ElapsedMs(start);
+
+        const RendererStats &stats = renderer.GetStats();
+        samples[kPhaseClear].push_back(stats.clear);
+        samples[kPhaseGame].push_back(gameTime);
+        samples[kPhaseSprites].push_back(stats.sprites);
+        samples[kPhaseText].push_back(stats.text);
+        samples[kPhaseRaster].push_back(stats.raster);
+        samples[kPhasePresent].push_back(presentTime);
+        samples[kPhaseFrame].push_back(ElapsedMs(frameStart));
+        commands += stats.commands;
+    }
+
+    printf("%dx%d, %d frames, %d equations, %d bullets per shot, %s, %.1f commands per frame\n",
+        width, height, frames, equations, bullets, (threads > 0) ? "binned" : "immediate",
+        (float)commands/std::max(1, frames));
+    const AssetCache &assets = game.GetAssets();
+    printf("%d images decoded, %d resident using %.1f MB\n", assets.GetDecodeCount(),
+        assets.GetImageCount(), assets.GetResidentSize()/(1024.f*1024.f));
+    printf("%-12s %10s %10s\n", "phase", "p50 ms", "p99 ms");
+    for (int p = 0; p < kPhaseCount; p++)
+        printf("%-12s %10.3f %10.3f\n", kPhaseNames[p], Percentile(samples[p], 50), Percentile(samples[p], 99));
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file swizzle_bench.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * Micro-benchmark of the swizzling kernels
+ * Compares the RGBA to BGRA conversion of decoded images with the previous
+ * per channel loop, and checks every kernel gives the same pixels
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "PixelOps.hpp"
+
+//==============================================================================
+// Reference implementation
+
+/* Swizzling loop previously used by ReadImage */
+static void SwizzleLoop(unsigned int *pixels, int count)
+{
+    unsigned int *pixel = pixels;
+    for (int x = 0; x < count; x++)
+    {
+        unsigned char r = (unsigned char)(*pixel & 0x0000ff);
+        unsigned char g = (unsigned char)((*pixel & 0x00ff00) >> 8);
+        unsigned char b = (unsigned char)((*pixel & 0xff0000) >> 16);
+        unsigned char a = (unsigned char)((*pixel & 0xff000000) >> 24);
+        *pixel++ = b | (g << 8) | (r << 16) | (a << 24);
+    }
+}
+
+//==============================================================================
+// Benchmark
+
+static const int kRuns = 20;
+
+// An image size
+struct ImageSize
+{
+    const char *name;
+    int width, height;
+};
+
+/* Returns the time in ms to swizzle an image, one row at a time */
+static double TimeSwizzle(SwizzleRowFunc swizzle, std::vector<unsigned int> &pixels, const ImageSize &size)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int run = 0; run < kRuns; run++)
+    {
+        for (int y = 0; y < size.height; y++)
+            swizzle(pixels.data() + y*size.width, size.width);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end-start).count()/kRuns;
+}
+
+int main()
+{
+    // Odd widths leave a remainder to the scalar tail of each kernel
+    ImageSize sizes[3] = {
+        {"256", 255, 256},
+        {"1024", 1023, 1024},
+        {"4096", 4095, 4096},
+    };
+
+    int result = 0;
+    srand(42);
+    for (const ImageSize &size : sizes)
+    {
+        std::vector<unsigned int> source(size.width*size.height);
+        for (unsigned int &pixel : source)
+            pixel = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
+
+        std::vector<unsigned int> expected = source;
+        SwizzleLoop(expected.data(), (int)expected.size());
+
+        std::vector<unsigned int> pixels = source;
+        double reference = TimeSwizzle(SwizzleLoop, pixels, size);
+        printf("%-6s %-8s %8.3f ms\n", size.name, "Loop", reference);
+
+        for (int k = 0; k < kKernelCount; k++)
+        {
+            PixelKernel kernel = (PixelKernel)k;
+            if (kernel == kKernelAVX2 && !CpuHasAvx2()) continue;
+            if (kernel == kKernelSSE2 && !CpuHasSse2()) continue;
+
+            pixels = source;
+            GetSwizzleRow(kernel)(pixels.data(), (int)pixels.size());
+            bool same = pixels == expected;
+            if (!same) result = 1;
+
+            double time = TimeSwizzle(GetSwizzleRow(kernel), pixels, size);
+            printf("%-6s %-8s %8.3f ms  x%.2f  %s\n", size.name, PixelKernelName(kernel), time,
+                reference/time, same ? "ok" : "MISMATCH");
+        }
+    }
+
+    return result;
+}
@@ -11,14 +11,17 @@
 #include <vector>
 #include <sstream>
 #include "FileReader.hpp"
+#include "AssetCache.hpp"
 #include "Vector.hpp"
 
+class ThreadPool;
+
 //==============================================================================
 // Animation class
 class Animation
 {
 private:
-    std::vector<Bitmap> _images;    // images of the animation
+    std::vector<ImageHandle> _images; // images of the animation, shared through the asset cache
     int _fps;                       // animation's fps
     int _frameLength;               // the number of frames in the animation
     bool _looping;                  // if the animation is looping
@@ -30,8 +33,10 @@ public:
      * Constructor
      * Takes a path to the image's folder, the animation's fps,
      * if the animation loops and if it returns to the default state on end
+     * Frames are loaded through an asset cache, which decodes the missing ones in parallel on pool
      */
-    Animation(const char *folderPath, int fps, bool looping, bool default = false);
+    Animation(AssetCache *cache, const char *folderPath, int fps, bool looping, bool returnToDefault = false, 
+        ThreadPool *pool = nullptr);
     ~Animation();
 
     /* Returns if the animation loops */
@@ -45,6 +50,6 @@ public:
     /* Returns the dimensions of each individual image */
     Vector2i GetImageDimensions() const;
     /* Returns an image at a given index */
-    Bitmap GetImage(int index);
+    Bitmap GetImage(int index) const;
 };
 
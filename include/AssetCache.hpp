@@ -0,0 +1,117 @@
+/**
+ * @file AssetCache.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the AssetCache class along with the ImageHandle class
+ * It is used to load each image file once and share it between it's users
+ * Decoded images can be packed in a texture atlas, whose pages are freed once all their images are released
+ */
+
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "FileReader.hpp"
+
+class AssetCache;
+class ThreadPool;
+class TexturePack;
+class TextureAtlas;
+
+// An image loaded by the AssetCache
+struct CachedImage
+{
+    std::string path;       // file the image was read from
+    bool premultiplied;     // if colors were multiplied by alpha on load
+    Bitmap bitmap;          // image data
+    bool owned;             // if the data is freed with the image. False for images of a texture pack
+    int page;               // atlas page holding the data, -1 if it isn't packed
+    int refCount;           // number of handles to the image
+};
+
+//==============================================================================
+// ImageHandle class
+// A shared reference to a cached image. The image is freed when it's last handle is destroyed
+class ImageHandle
+{
+private:
+    AssetCache *_cache = nullptr;           // cache the image belongs to
+    CachedImage *_image = nullptr;          // referenced image. Null if the handle is empty
+
+    friend class AssetCache;
+    ImageHandle(AssetCache *cache, CachedImage *image);
+
+public:
+    ImageHandle() {}
+    ImageHandle(const ImageHandle &other);
+    ImageHandle(ImageHandle &&other);
+    ImageHandle &operator=(const ImageHandle &other);
+    ImageHandle &operator=(ImageHandle &&other);
+    ~ImageHandle();
+
+    /* Drops the reference to the image, and frees it if it was the last one */
+    void Reset();
+    /* Returns the image. Empty if the handle is empty or the file couldn't be read */
+    Bitmap Get() const;
+    /* Returns true if the handle references an image */
+    bool IsValid() const;
+};
+
+//==============================================================================
+// AssetCache class
+// Must outlive every handle it returned. Not thread safe
+class AssetCache
+{
+private:
+    std::map<std::pair<std::string, bool>, CachedImage *> _images;  // loaded images, by path and premultiplication
+    size_t _residentSize = 0;               // memory used by loaded images in bytes
+    int _decodeCount = 0;                   // number of files decoded since creation
+    const TexturePack *_pack = nullptr;     // pack searched before decoding files. Can be null
+    TextureAtlas *_atlas = nullptr;         // atlas decoded images are packed in. Can be null
+
+    friend class ImageHandle;
+    /* Drops a reference to an image, and frees it if it was the last one */
+    void Release(CachedImage *image);
+    /* Adds an image to the cache. Owned images are packed in the atlas, or freed with FreeImage without one */
+    CachedImage *Insert(const char *filePath, bool premultiply, Bitmap bitmap, bool owned);
+    /* Returns the packed version of an image file. Empty if it isn't packed the same way */
+    Bitmap FindPacked(const char *filePath, bool premultiply) const;
+
+public:
+    AssetCache();
+    ~AssetCache();
+
+    /**
+     * Returns a handle to an image file. The file is only read if it isn't already loaded
+     * If premultiply is true, colors are multiplied by alpha on load, see ReadImage
+     */
+    ImageHandle Load(const char *filePath, bool premultiply = false);
+    /**
+     * Returns a handle to each image file, in order
+     * The files that aren't loaded yet are decoded in parallel on pool, or one after the other if it is null
+     */
+    std::vector<ImageHandle> LoadAll(const std::vector<const char *> &filePaths, bool premultiply, ThreadPool *pool);
+
+    /**
+     * Sets a texture pack. Images found in it are used without decoding their file
+     * The pack must outlive the images loaded from it
+     */
+    void SetPack(const TexturePack *pack);
+    /**
+     * Sets an atlas. Images decoded from then on are packed in it, and handles to them reference
+     * their rect in a page. A page is freed once all it's images are released
+     * Must be set before loading images. The atlas must outlive the cache
+     */
+    void SetAtlas(TextureAtlas *atlas);
+
+    /* Returns the number of loaded images */
+    int GetImageCount() const;
+    /**
+     * Returns the memory used by decoded images in bytes: the pages of the atlas, and the pixels and spans
+     * of images decoded without one. Images of a texture pack are mapped
+     */
+    size_t GetResidentSize() const;
+    /* Returns the number of files decoded since creation */
+    int GetDecodeCount() const;
+};
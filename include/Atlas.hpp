@@ -0,0 +1,67 @@
+/**
+ * @file Atlas.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the TextureAtlas class
+ * It is used to pack many images in a few large bitmaps
+ * Pages are freed once every image packed in them is removed
+ */
+
+#pragma once
+#include <vector>
+#include "FileReader.hpp"
+
+// A segment of the top edge of the packed images
+struct SkylineSegment
+{
+    int x, y;               // left end of the segment and height of the images below it
+    int width;              // segment width
+};
+
+// A large bitmap images are packed in
+struct AtlasPage
+{
+    int width, height;                  // page dimensions
+    std::vector<unsigned int> pixels;   // color data of every packed image
+    std::vector<SkylineSegment> skyline;// top edge of the packed images, from left to right
+    std::vector<SpanTable *> spans;     // spans of every packed image
+    int imageCount;                     // images packed and not removed yet
+};
+
+//==============================================================================
+// TextureAtlas class
+class TextureAtlas
+{
+private:
+    int _pageWidth, _pageHeight;        // dimensions of new pages
+    std::vector<AtlasPage *> _pages;    // pages images are packed in. Null once freed
+
+    /**
+     * Finds the lowest place for a width*height rect in a page. Returns false if it doesn't fit
+     * Sets x and y to the bottom left corner of the rect, and segment to the skyline segment under it
+     */
+    bool FindPosition(const AtlasPage *page, int width, int height, int &x, int &y, int &segment) const;
+    /* Raises the skyline of a page over a newly placed rect */
+    void AddToSkyline(AtlasPage *page, int segment, int x, int y, int width, int height);
+
+public:
+    /**
+     * Constructor
+     * Takes the dimensions of each page. Bigger images get a page of their own
+     */
+    TextureAtlas(int pageWidth = 1024, int pageHeight = 1024);
+    ~TextureAtlas();
+
+    /**
+     * Copies an image in the atlas and frees it with FreeImage. The atlas keeps it's spans
+     * Returns a view of the image in the atlas, valid until it's page is freed, and sets page to it's page index
+     */
+    Bitmap Add(Bitmap image, int *page = nullptr);
+    /* Removes an image of a page. The page is freed with the last one, and it's views can't be used anymore */
+    void Remove(int page);
+    /* Returns the number of pages in use */
+    int GetPageCount() const;
+    /* Returns the memory used by the pages in bytes */
+    size_t GetMemorySize() const;
+};
@@ -0,0 +1,76 @@
+/**
+ * @file Entities.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the EntityStore struct
+ * Entities of a same kind are kept as a structure of arrays, so the game's
+ * update, collision and drawing loops go through contiguous memory
+ * A store has a fixed capacity: its arrays are allocated once, and entities
+ * are added and removed in constant time without allocating
+ */
+
+#pragma once
+#include <vector>
+#include "Vector.hpp"
+
+class Sprite;
+
+/**
+ * A stable reference to an entity
+ * Indices change when other entities are removed, handles don't. A handle to a
+ * removed entity is never valid again, even once its slot is reused
+ */
+struct EntityHandle
+{
+    int slot;               // slot of the entity in the store. -1 if the handle is invalid
+    int generation;         // number of times the slot was freed when the handle was made
+};
+
+//==============================================================================
+// EntityStore struct
+struct EntityStore
+{
+    std::vector<Vector2f> positions;    // center of each entity
+    std::vector<Vector2f> previousPositions; // center of each entity at the previous simulation step
+    std::vector<Vector2f> halfSizes;    // half size of each entity's bounding box
+    std::vector<Vector2f> velocities;   // move of each entity in pixels per second
+    std::vector<int> hitPoints;         // hits each entity can still take
+    std::vector<Sprite *> sprites;      // sprite following each entity. Can be null
+
+    /* Allocates a store for up to capacity entities */
+    EntityStore(int capacity);
+
+    /**
+     * Adds an entity
+     * Returns its handle, or an invalid handle if the store is full
+     */
+    EntityHandle Add(Vector2f pos, Vector2f hSize, Vector2f velocity, int hp = 1, Sprite *sprite = nullptr);
+    /**
+     * Removes an entity by moving the last one in its place
+     * Loops removing entities while going through the store must not increment their index after a removal
+     */
+    void Remove(int index);
+    /* Removes an entity by handle. Invalid handles are ignored */
+    void Remove(EntityHandle handle);
+    /* Removes every entity. Their handles become invalid */
+    void Clear();
+    /* Removes every entity and changes the capacity of the store */
+    void SetCapacity(int capacity);
+
+    /* Returns the index of an entity, or -1 if the handle is invalid */
+    int GetIndex(EntityHandle handle) const;
+    /* Returns the handle of the entity at an index */
+    EntityHandle GetHandle(int index) const;
+    /* Returns the number of entities */
+    int GetCount() const;
+    /* Returns the maximum number of entities */
+    int GetCapacity() const;
+
+private:
+    std::vector<int> _slots;            // slot of each entity
+    std::vector<int> _indices;          // index of the entity using each slot
+    std::vector<int> _generations;      // generation of each slot, increased when it is freed
+    std::vector<int> _freeSlots;        // slots not used by an entity
+    int _capacity;                      // maximum number of entities
+};
@@ -8,19 +8,73 @@
 
 #pragma once
 
+#include <limits.h>
+#include <stdio.h>
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
 #include <vector>
 #include <sstream>
+// stb's failure reason is a global written by every failed check, which races between threads
+#define STBI_NO_FAILURE_STRINGS
+#if defined(STB_IMAGE_IMPLEMENTATION) && defined(__GNUC__)
+// Without failure strings, stb's implementation no longer calls it's stbi__err function
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
 #include "stb_image.h"
+#pragma GCC diagnostic pop
+#else
+#include "stb_image.h"
+#endif
+#include "PixelOps.hpp"
 
 //==============================================================================
 // File types
 
-/* A file data */
-struct FileString
+static const size_t kFileStreamChunkSize = 64*1024;    // bytes read from disk at once by a FileStream
+
+/* A file read in chunks */
+struct FileStream
+{
+    FILE *file;             // opened file. Null if the file can't be opened
+    bool failed;            // true once a read failed
+};
+
+/* A file mapped in memory */
+struct MappedFile
+{
+    const unsigned char *data;  // file data. Read only, pages are loaded on first access
+    long long size;             // file size
+};
+
+/* The different kinds of pixel runs in an image row */
+enum SpanType
+{
+    kSpanSkip,              // fully transparent pixels
+    kSpanCopy,              // fully opaque pixels
+    kSpanBlend,             // translucent pixels
+};
+
+/* A run of pixels of the same kind in an image row */
+struct PixelSpan
 {
-    unsigned char *data;    // data string
-    long long size;         // file size
+    int start, end;         // first and past the last pixel of the run
+    int type;               // span type
+};
+
+/* Runs of pixels of each row of an image */
+struct SpanTable
+{
+    std::vector<int> rows;          // index of the first span of each row. Has height+1 elements
+    std::vector<PixelSpan> spans;   // spans of every row, one row after the other
 };
 
 /* An image data */
@@ -28,79 +82,246 @@ struct Bitmap
 {
     int width, height;      // image dimensions
     unsigned int *pixels;   // color data
+    int pitch;              // pixels from the start of a row to the next. Bigger than width in atlases
+    SpanTable *spans;       // pixel runs of each row. Can be null, the image is then fully blended
+    bool premultiplied;     // true if colors are already multiplied by alpha
 };
 
 //==============================================================================
 // File reading implementation
 
-/* Free a readed file */
-inline void FreeFile(FileString s)
+/**
+ * Opens a file for reading in chunks of kFileStreamChunkSize bytes
+ * Returns a FileStream with a null file if the file can't be opened
+ * Streams must be closed after use
+ */
+inline FileStream OpenFileStream(const char *filePath)
 {
-    VirtualFree(s.data, 0, MEM_RELEASE);
+    FileStream result = {0};
+#ifdef _MSC_VER
+    fopen_s(&result.file, filePath, "rb");
+#else
+    result.file = fopen(filePath, "rb");
+#endif
+    if (result.file)
+        setvbuf(result.file, 0, _IOFBF, kFileStreamChunkSize);
+    return result;
 }
 
-/** 
- * Reads a file using it's path 
- * Returns a FileString containing data
- * Files must be freed after use
+/* Reads up to size bytes from a stream. Returns the number of bytes read */
+inline size_t ReadFileStream(FileStream &stream, void *buffer, size_t size)
+{
+    if (!stream.file || stream.failed)
+        return 0;
+
+    size_t read = fread(buffer, 1, size, stream.file);
+    if (read < size && ferror(stream.file))
+        stream.failed = true;
+    return read;
+}
+
+/* Moves forward, or backward if count is negative, in a stream */
+inline void SkipFileStream(FileStream &stream, long count)
+{
+    if (stream.file && !stream.failed && fseek(stream.file, count, SEEK_CUR))
+        stream.failed = true;
+}
+
+/* Returns true once a stream has no more data to read */
+inline bool EndOfFileStream(const FileStream &stream)
+{
+    return !stream.file || stream.failed || feof(stream.file);
+}
+
+/* Closes a stream opened with OpenFileStream */
+inline void CloseFileStream(FileStream &stream)
+{
+    if (stream.file)
+        fclose(stream.file);
+    stream.file = 0;
+}
+
+/**
+ * Maps a file in memory using it's path
+ * Returns a MappedFile with null data if the file can't be mapped
+ * Files must be unmapped after use
  */
-inline FileString ReadFile(const char *filePath)
+inline MappedFile MapFile(const char *filePath)
 {
-    FileString result = {0};
+    MappedFile result = {0};
 
+#ifdef _WIN32
     HANDLE handle = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
     if (handle == INVALID_HANDLE_VALUE)
+        return result;
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(handle, &size) && size.QuadPart > 0)
     {
-        CloseHandle(handle);
+        // The view keeps the file and the mapping open
+        HANDLE mapping = CreateFileMappingA(handle, 0, PAGE_READONLY, 0, 0, 0);
+        if (mapping)
+        {
+            result.data = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            result.size = (result.data) ? size.QuadPart : 0;
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(handle);
+#else
+    int descriptor = open(filePath, O_RDONLY);
+    if (descriptor < 0)
         return result;
+
+    struct stat info;
+    if (fstat(descriptor, &info) == 0 && info.st_size > 0)
+    {
+        void *data = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data != MAP_FAILED)
+        {
+            result.data = (const unsigned char *)data;
+            result.size = info.st_size;
+        }
     }
+    close(descriptor);
+#endif
+    return result;
+}
 
-    DWORD file_size = GetFileSize(handle, 0);
-    result.size = file_size;
-    result.data = (unsigned char *)VirtualAlloc(0, (size_t)result.size, MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+/* Unmaps a file mapped with MapFile */
+inline void UnmapFile(MappedFile &file)
+{
+    if (!file.data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(file.data);
+#else
+    munmap((void *)file.data, (size_t)file.size);
+#endif
+    file.data = 0;
+    file.size = 0;
+}
 
-    DWORD bytesRead;
-    ReadFile(handle, result.data, file_size, &bytesRead, 0);
+//==============================================================================
+// Image reading implementation
 
-    CloseHandle(handle);
-    return result;
+/* Reads a stream for stb_image */
+inline int StbStreamRead(void *user, char *data, int size)
+{
+    return (int)ReadFileStream(*(FileStream *)user, data, (size_t)size);
+}
+
+/* Skips bytes of a stream for stb_image */
+inline void StbStreamSkip(void *user, int count)
+{
+    SkipFileStream(*(FileStream *)user, count);
+}
+
+/* Returns true at the end of a stream for stb_image */
+inline int StbStreamEof(void *user)
+{
+    return EndOfFileStream(*(FileStream *)user);
+}
+
+/**
+ * Decodes an image file to 32 bits RGBA pixels
+ * The file is decoded straight from a mapping of it, so it is never copied in memory
+ * If it can't be mapped, it is streamed to stb_image in chunks instead
+ * Returns null if the file can't be read or decoded
+ */
+inline unsigned char *DecodeImageFile(const char *filePath, int *width, int *height)
+{
+    int n;
+    MappedFile file = MapFile(filePath);
+    if (file.data && file.size <= INT_MAX)
+    {
+        unsigned char *pixels = stbi_load_from_memory(file.data, (int)file.size, width, height, &n, 4);
+        UnmapFile(file);
+        return pixels;
+    }
+    UnmapFile(file);
+
+    FileStream stream = OpenFileStream(filePath);
+    if (!stream.file)
+        return 0;
+    stbi_io_callbacks callbacks = {StbStreamRead, StbStreamSkip, StbStreamEof};
+    unsigned char *pixels = stbi_load_from_callbacks(&callbacks, &stream, width, height, &n, 4);
+    CloseFileStream(stream);
+    return pixels;
 }
 
 /** 
  * Reads an image using it's path 
  * Returns a Bitmap containing data
+ * Rows are flipped to start from the bottom and swizzled to BGRA, then each row
+ * is split in skip, copy and blend spans
+ * If premultiply is true, colors are multiplied by alpha while spans are built
+ * Can be called from several threads at once
  */
-inline Bitmap ReadImage(const char *filePath)
+inline Bitmap ReadImage(const char *filePath, bool premultiply = false)
 {
     Bitmap result;
     
-    FileString image = ReadFile(filePath);
-    int n;
-    stbi_set_flip_vertically_on_load(1);
-    result.pixels = (unsigned int *)stbi_load_from_memory(image.data, (int)image.size, &result.width, &result.height, &n, 4);
-    unsigned int *pixel = result.pixels;
+    result.pixels = (unsigned int *)DecodeImageFile(filePath, &result.width, &result.height);
+    result.spans = 0;
+    result.premultiplied = premultiply;
+    result.pitch = result.width;
+    if (!result.pixels)
+    {
+        result.width = result.height = result.pitch = 0;
+        return result;
+    }
+
+    SpanTable *spans = new SpanTable;
+    spans->rows.reserve(result.height+1);
     for (int y = 0; y < result.height; y++) 
     {
+        // stb's own flip is a global setting, so rows are swapped here before being swizzled
+        unsigned int *pixel = result.pixels + y*result.width;
+        int flippedY = result.height-1-y;
+        if (y < flippedY)
+            std::swap_ranges(pixel, pixel+result.width, result.pixels + flippedY*result.width);
+
+        SwizzleRow(pixel, result.width);
+
+        int rowStart = (int)spans->spans.size();
+        spans->rows.push_back(rowStart);
         for (int x = 0; x < result.width; x++) 
         {
-            unsigned char r = (unsigned char)(*pixel & 0x0000ff);
-            unsigned char g = (unsigned char)((*pixel & 0x00ff00) >> 8);
-            unsigned char b = (unsigned char)((*pixel & 0xff0000) >> 16);
-            unsigned char a = (unsigned char)((*pixel & 0xff000000) >> 24);
-            *pixel++ =  b | (g << 8) | (r << 16) | (a << 24);
+            unsigned int a = *pixel >> 24;
+            if (premultiply && a != 255)
+                *pixel = PremultiplyPixel(*pixel);
+            pixel++;
+
+            int type = (a == 0) ? kSpanSkip : ((a == 255) ? kSpanCopy : kSpanBlend);
+            if ((int)spans->spans.size() == rowStart || spans->spans.back().type != type)
+                spans->spans.push_back({x, x+1, type});
+            else
+                spans->spans.back().end++;
         }
     }
-    
-    FreeFile(image);
+    spans->rows.push_back((int)spans->spans.size());
+    result.spans = spans;
     return result;
 }
 
+/* Frees the pixels and spans of an image read with ReadImage */
+inline void FreeImage(Bitmap &image)
+{
+    stbi_image_free(image.pixels);
+    delete image.spans;
+    image.pixels = 0;
+    image.spans = 0;
+    image.width = image.height = image.pitch = 0;
+}
+
 /**  
  * Returns the number of files in a folder
  */
 inline int NumberOfFiles(const char *path)
 {
     int nb = 0;
+#ifdef _WIN32
     std::stringstream fPath;
     fPath << path << "\\*";
 
@@ -112,4 +333,17 @@ inline int NumberOfFiles(const char *path)
     }
     FindClose(hFind);
     return nb-1;
+#else
+    DIR *dir = opendir(path);
+    if (!dir)
+        return 0;
+
+    while (dirent *entry = readdir(dir))
+    {
+        if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
+            nb++;
+    }
+    closedir(dir);
+    return nb;
+#endif
 }
\ No newline at end of file
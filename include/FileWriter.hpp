@@ -0,0 +1,164 @@
+/**
+ * @file FileWriter.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines a file writing library
+ * It is used to dump frames as PNG or raw files
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+//==============================================================================
+// File writing implementation
+
+/* Opens a file for writing. Returns null on failure */
+inline FILE *OpenFileForWriting(const char *filePath)
+{
+#ifdef _MSC_VER
+    FILE *file = 0;
+    fopen_s(&file, filePath, "wb");
+    return file;
+#else
+    return fopen(filePath, "wb");
+#endif
+}
+
+/**
+ * Writes a pixel buffer as is: 32 bits BGRA pixels, rows one after the other
+ * Returns false if the file can't be written
+ */
+inline bool WriteRaw(const char *filePath, const unsigned int *pixels, int width, int height)
+{
+    FILE *file = OpenFileForWriting(filePath);
+    if (!file)
+        return false;
+
+    size_t count = (size_t)width*height;
+    bool written = fwrite(pixels, sizeof(unsigned int), count, file) == count;
+    fclose(file);
+    return written;
+}
+
+//==============================================================================
+// PNG writing implementation
+
+/* Returns the CRC32 of data, continuing from a previous crc */
+inline unsigned int Crc32(const unsigned char *data, size_t size, unsigned int crc = 0)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+/* Returns the Adler32 checksum of data */
+inline unsigned int Adler32(const unsigned char *data, size_t size)
+{
+    unsigned int a = 1, b = 0;
+    while (size > 0)
+    {
+        // 5552 bytes is the most that can be summed before b overflows
+        size_t block = (size < 5552) ? size : 5552;
+        size -= block;
+        for (size_t i = 0; i < block; i++)
+        {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+/* Appends a 32 bits big endian value */
+inline void PushBigEndian(std::vector<unsigned char> &out, unsigned int value)
+{
+    out.push_back((unsigned char)(value >> 24));
+    out.push_back((unsigned char)(value >> 16));
+    out.push_back((unsigned char)(value >> 8));
+    out.push_back((unsigned char)value);
+}
+
+/* Appends a PNG chunk with it's length and CRC */
+inline void PushPngChunk(std::vector<unsigned char> &out, const char *type, const std::vector<unsigned char> &data)
+{
+    PushBigEndian(out, (unsigned int)data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type+4);
+    out.insert(out.end(), data.begin(), data.end());
+    PushBigEndian(out, Crc32(out.data()+start, out.size()-start));
+}
+
+/**
+ * Writes a pixel buffer as a 24 bits PNG
+ * Takes 32 bits BGRA pixels. If bottomUp is true, the first row is the bottom of the image
+ * Data isn't compressed: it is stored in raw deflate blocks, which is fast to write
+ * Returns false if the file can't be written
+ */
+inline bool WritePng(const char *filePath, const unsigned int *pixels, int width, int height, bool bottomUp)
+{
+    // Filtered scanlines: a filter byte, then RGB pixels
+    size_t stride = (size_t)width*3 + 1;
+    std::vector<unsigned char> raw(stride*height);
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned int *src = pixels + (size_t)(bottomUp ? height-1-y : y)*width;
+        unsigned char *dst = raw.data() + y*stride;
+        *dst++ = 0;
+        for (int x = 0; x < width; x++)
+        {
+            *dst++ = (unsigned char)(src[x] >> 16);
+            *dst++ = (unsigned char)(src[x] >> 8);
+            *dst++ = (unsigned char)src[x];
+        }
+    }
+
+    // zlib stream made of stored blocks of at most 65535 bytes
+    std::vector<unsigned char> idat = {0x78, 0x01};
+    size_t offset = 0;
+    do
+    {
+        size_t size = raw.size()-offset;
+        if (size > 65535) size = 65535;
+        bool last = offset+size == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back((unsigned char)size);
+        idat.push_back((unsigned char)(size >> 8));
+        idat.push_back((unsigned char)~size);
+        idat.push_back((unsigned char)(~size >> 8));
+        idat.insert(idat.end(), raw.begin()+offset, raw.begin()+offset+size);
+        offset += size;
+    } while (offset < raw.size());
+    PushBigEndian(idat, Adler32(raw.data(), raw.size()));
+
+    std::vector<unsigned char> ihdr;
+    PushBigEndian(ihdr, (unsigned int)width);
+    PushBigEndian(ihdr, (unsigned int)height);
+    ihdr.push_back(8);      // bit depth
+    ihdr.push_back(2);      // color type: RGB
+    ihdr.push_back(0);      // compression
+    ihdr.push_back(0);      // filter
+    ihdr.push_back(0);      // interlace
+
+    std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    PushPngChunk(png, "IHDR", ihdr);
+    PushPngChunk(png, "IDAT", idat);
+    PushPngChunk(png, "IEND", {});
+
+    FILE *file = OpenFileForWriting(filePath);
+    if (!file)
+        return false;
+
+    bool written = fwrite(png.data(), 1, png.size(), file) == png.size();
+    fclose(file);
+    return written;
+}
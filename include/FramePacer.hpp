@@ -0,0 +1,72 @@
+/**
+ * @file FramePacer.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the FramePacer class
+ * It holds frames to a target frame rate: it sleeps until shortly before the
+ * frame's deadline, then spins on a monotonic clock until the deadline itself.
+ * It also keeps a histogram of the time between frames and counts the frames
+ * that missed their deadline
+ */
+
+#pragma once
+#include <chrono>
+#include <stdio.h>
+
+static const int kPacerBuckets = 50;        // histogram buckets of 1ms. The last one holds longer frames
+
+// Pacing statistics, since creation or the last reset
+struct PacerStats
+{
+    int frames;                         // number of paced frames
+    int missed;                         // frames ready after their deadline
+    int lateWakes;                      // frames the pacer itself woke up late for
+    float worstLateWake;                // longest late wake in ms
+    int histogram[kPacerBuckets];       // number of frames by time since the previous frame, in ms
+};
+
+//==============================================================================
+// FramePacer class
+class FramePacer
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    double _targetTime = 0;             // time between frames in seconds. 0 leaves frames uncapped
+    double _spinTime = .002;            // time spun before a deadline instead of sleeping, in seconds
+    Clock::time_point _deadline;        // time the next frame is due
+    Clock::time_point _lastFrame;       // time the last frame was released
+    bool _started = false;              // if Wait was called once. The first deadline is set then
+    PacerStats _stats;                  // pacing statistics
+
+public:
+    /**
+     * Constructor
+     * Takes the target frame rate. 0 leaves frames uncapped
+     */
+    FramePacer(float fps = 60);
+    ~FramePacer();
+
+    /**
+     * Waits for the deadline of the current frame, then starts the next one
+     * A frame ready after its deadline is counted as missed, and the next deadline starts from it
+     * The first call doesn't wait and isn't counted: it starts the cadence
+     * Returns the time since the previous frame in seconds, or the target time on the first call
+     */
+    float Wait();
+
+    /* Sets the target frame rate, usually 60, 120 or 144. 0 leaves frames uncapped */
+    void SetTarget(float fps);
+    /* Sets how long to spin before each deadline, in ms. Longer spins cost cpu but wake up on time */
+    void SetSpinTime(float ms);
+    /* Returns the target frame rate. 0 if frames are uncapped */
+    float GetTarget() const;
+
+    /* Returns the pacing statistics */
+    const PacerStats &GetStats() const;
+    /* Clears the pacing statistics */
+    void ResetStats();
+    /* Writes a summary of the statistics and the histogram */
+    void Report(FILE *file) const;
+};
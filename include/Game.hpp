@@ -10,14 +10,31 @@
 #pragma once
 #include "Renderer.hpp"
 #include "Input.hpp"
+#include "AssetCache.hpp"
 
 class Game
 {
 private:
+    /* Advances the simulation by a step of dt seconds */
+    void Step(Input *input, float dt);
+    /* Draws the game between the last two steps. alpha is the time past the last step, in steps */
+    void Draw(Renderer *r, float alpha);
+
 public:
     Game();
     ~Game();
 
-    void Init(Renderer *r);
+    /**
+     * Creates the game objects
+     * The number of equations and of bullets fired per shot can be raised to stress the game
+     */
+    void Init(Renderer *r, int equationCount = 4, int bulletsPerShot = 1);
+    /**
+     * Advances the simulation by the time of a frame and draws it
+     * The simulation runs in fixed steps of 1/120s whatever the frame rate. Frames longer than 1/4s slow the game down
+     */
     void Update(Renderer *r, Input *input, float dt);
+
+    /* Returns the cache of the game's images */
+    const AssetCache &GetAssets() const;
 };
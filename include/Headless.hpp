@@ -0,0 +1,102 @@
+/**
+ * @file Headless.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the HeadlessWindow class
+ * It is used to run the game offscreen, without a display
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Window.hpp"
+#include "Input.hpp"
+
+// The file formats of dumped frames
+enum DumpFormat
+{
+    kDumpPng,               // 24 bits PNG, top row first
+    kDumpRaw,               // pixel buffer as is: 32 bits BGRA, bottom row first
+};
+
+//==============================================================================
+// HeadlessWindow class
+// Has the same interface as Window, but owns an offscreen buffer and runs at a fixed frame time
+// unless it is paced
+class HeadlessWindow
+{
+private:
+    WinBuffer _buffer;                      // pixel buffer
+    std::vector<unsigned int> _pixels;      // storage of the pixel buffer
+    const WinBuffer *_presented = nullptr;  // last buffer presented from a render thread. Null if there is none
+    bool _pipelined = false;                // if frames come from a render thread. The own buffer is then unused
+    float _ft;                              // fixed frame time
+    FramePacer _pacer;                      // holds frames to real time when pacing is enabled
+    bool _paced = false;                    // if frames are paced, the frame time is then measured
+    float _lastFt = 0;                      // last paced frame's time
+    int _frame = 0;                         // number of processed frames
+    int _frameLimit = 0;                    // number of frames before stopping. 0 runs until closed
+    bool _running = true;                   // used to stop the program
+
+    std::string _dumpFolder;                // folder frames are written to. Empty if they aren't
+    int _dumpEvery = 1;                     // writes one frame out of that many
+    DumpFormat _dumpFormat = kDumpPng;      // file format of written frames
+
+    /* Writes the current frame to the dump folder */
+    void DumpFrame();
+
+public:
+    /**
+     * Constructor
+     * Takes dimensions of the buffer and the frame time given to the game each frame
+     */
+    HeadlessWindow(int width, int height, float ft = 1.f/60.f);
+    ~HeadlessWindow();
+
+    /* Does nothing: input is set directly by the caller */
+    void HandleMessages();
+    /* Ends the frame and dumps it if needed */
+    void ProcessFrame();
+    /* Ends the frame and dumps it if needed. The whole buffer is always dumped */
+    void ProcessFrame(const std::vector<ScreenRect> &dirtyRects);
+    /**
+     * Ends the frame with a buffer completed by a render thread, and dumps it if needed
+     * Null keeps the previous one. The buffer must stay untouched until the next one
+     */
+    void ProcessFrame(const WinBuffer *buffer);
+    /* Forgets the buffer presented from a render thread. Called before the render thread is destroyed */
+    void StopPresenting();
+
+    /* Does nothing: there is no window to stretch */
+    void SetBackgroundColor(unsigned int color) const;
+    /* Stops the program after frameCount frames. 0 runs until Close is called */
+    void SetFrameLimit(int frameCount);
+    /**
+     * Writes one frame out of every to folder, in the given format
+     * Files are named frame_00000.png or frame_00000.raw after their frame index
+     * The folder must already exist
+     */
+    void SetFrameDump(const char *folder, int every = 1, DumpFormat format = kDumpPng);
+    /**
+     * Paces frames to fps in real time, like Window does. 0 runs uncapped but in real time
+     * The frame time is then measured instead of fixed
+     */
+    void EnablePacing(float fps);
+    /* Stops the program */
+    void Close();
+
+    /* Returns true if the program is currently running */
+    bool IsRunning() const;
+    /* Returns a pointer to the pixel buffer */
+    WinBuffer *GetBuffer();
+    /* Returns the fixed frame time, or the last frame's time when paced */
+    float GetFt() const;
+    /* Returns the number of processed frames */
+    int GetFrameCount() const;
+    /* Returns the frame pacer. Only used when pacing is enabled */
+    FramePacer &GetPacer();
+
+    Input input;    // user input. Can be scripted by the caller
+};
@@ -31,6 +31,22 @@ inline float Square(float x)
 //==============================================================================
 // Value limitation
 
+#ifndef _WIN32
+/* Returns the smallest of a and b. Windows.h defines it as a macro */
+template <typename T>
+inline T min(T a, T b)
+{
+    return (a < b) ? a : b;
+}
+
+/* Returns the biggest of a and b. Windows.h defines it as a macro */
+template <typename T>
+inline T max(T a, T b)
+{
+    return (a > b) ? a : b;
+}
+#endif
+
 /* Clamp a value between a min and a max. Only takes integers */
 inline int Clamp(int min, int val, int max)
 {
@@ -0,0 +1,547 @@
+/**
+ * @file PixelOps.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the pixel kernels used by the Renderer
+ * Each kernel has a scalar, SSE2 and AVX2 version chosen at runtime
+ */
+
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXELOPS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PIXELOPS_AVX2
+#else
+#define PIXELOPS_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+//==============================================================================
+// Kernel selection
+
+/* The different instruction sets a kernel can be written for */
+enum PixelKernel
+{
+    kKernelScalar,
+    kKernelSSE2,
+    kKernelAVX2,
+
+    kKernelCount
+};
+
+/* Returns the name of a kernel */
+inline const char *PixelKernelName(PixelKernel k)
+{
+    if (k == kKernelAVX2) return "AVX2";
+    if (k == kKernelSSE2) return "SSE2";
+    return "Scalar";
+}
+
+/* Returns true if the cpu and the os support AVX2 */
+inline bool CpuHasAvx2()
+{
+#if defined(PIXELOPS_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(PIXELOPS_X86)
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+/* Returns true if the cpu supports SSE2 */
+inline bool CpuHasSse2()
+{
+#if defined(PIXELOPS_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#elif defined(PIXELOPS_X86)
+    return __builtin_cpu_supports("sse2") != 0;
+#else
+    return false;
+#endif
+}
+
+/* Returns the fastest kernel supported by the cpu. Detected once */
+inline PixelKernel BestPixelKernel()
+{
+    static PixelKernel best = CpuHasAvx2() ? kKernelAVX2 :
+        (CpuHasSse2() ? kKernelSSE2 : kKernelScalar);
+    return best;
+}
+
+//==============================================================================
+// Alpha blending
+// dst = (src*a + dst*(255-a))/255 with a rounded integer division by 255.
+// Premultiplied sources already hold src*a/255, so only dst is scaled.
+// The alpha byte of the result is cleared, like the window buffer expects.
+// Opaque pixels aren't blended but copied, and their alpha byte is cleared too
+
+/* Blends a single src pixel over a dst pixel */
+inline unsigned int BlendPixel(unsigned int dst, unsigned int src)
+{
+    unsigned int a = src >> 24;
+    unsigned int ia = 255 - a;
+
+    // red and blue are computed together in two 16 bits fields
+    unsigned int rb = (dst & 0xff00ff)*ia + (src & 0xff00ff)*a + 0x800080;
+    rb = ((rb + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+
+    unsigned int g = ((dst >> 8) & 0xff)*ia + ((src >> 8) & 0xff)*a + 0x80;
+    g = (g + (g >> 8)) >> 8;
+
+    return rb | (g << 8);
+}
+
+/* Blends count src pixels over dst. Scalar version */
+inline void BlendRowScalar(unsigned int *dst, const unsigned int *src, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = BlendPixel(dst[i], src[i]);
+}
+
+/* Blends a single premultiplied src pixel over a dst pixel: dst = src + dst*(255-a)/255 */
+inline unsigned int BlendPixelPremultiplied(unsigned int dst, unsigned int src)
+{
+    unsigned int ia = 255 - (src >> 24);
+
+    unsigned int rb = (dst & 0xff00ff)*ia + 0x800080;
+    rb = ((rb + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+
+    unsigned int g = ((dst >> 8) & 0xff)*ia + 0x80;
+    g = (g + (g >> 8)) >> 8;
+
+    return ((src & 0xffffff) + (rb | (g << 8)));
+}
+
+/* Blends count premultiplied src pixels over dst. Scalar version */
+inline void BlendRowPremultipliedScalar(unsigned int *dst, const unsigned int *src, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = BlendPixelPremultiplied(dst[i], src[i]);
+}
+
+#ifdef PIXELOPS_X86
+/* Blends 8 16 bits channels (2 pixels). Alpha is read from the src pixels */
+inline __m128i BlendChannelsSSE2(__m128i d, __m128i s)
+{
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i c128 = _mm_set1_epi16(128);
+
+    __m128i a = _mm_shufflelo_epi16(s, _MM_SHUFFLE(3,3,3,3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3,3,3,3));
+    __m128i ia = _mm_sub_epi16(c255, a);
+
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, ia));
+    x = _mm_add_epi16(x, c128);
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/* Blends count src pixels over dst. 4 pixels per iteration */
+inline void BlendRowSSE2(unsigned int *dst, const unsigned int *src, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+
+    int i = 0;
+    for (; i+4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src+i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst+i));
+
+        __m128i lo = BlendChannelsSSE2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+        __m128i hi = BlendChannelsSSE2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+
+        __m128i result = _mm_and_si128(_mm_packus_epi16(lo, hi), rgbMask);
+        _mm_storeu_si128((__m128i *)(dst+i), result);
+    }
+    BlendRowScalar(dst+i, src+i, count-i);
+}
+
+/* Blends 8 16 bits premultiplied channels (2 pixels). Alpha is read from the src pixels */
+inline __m128i BlendChannelsPremultipliedSSE2(__m128i d, __m128i s)
+{
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i c128 = _mm_set1_epi16(128);
+
+    __m128i a = _mm_shufflelo_epi16(s, _MM_SHUFFLE(3,3,3,3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3,3,3,3));
+    __m128i ia = _mm_sub_epi16(c255, a);
+
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(d, ia), c128);
+    x = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    return _mm_add_epi16(s, x);
+}
+
+/* Blends count premultiplied src pixels over dst. 4 pixels per iteration */
+inline void BlendRowPremultipliedSSE2(unsigned int *dst, const unsigned int *src, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+
+    int i = 0;
+    for (; i+4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src+i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst+i));
+
+        __m128i lo = BlendChannelsPremultipliedSSE2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+        __m128i hi = BlendChannelsPremultipliedSSE2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+
+        __m128i result = _mm_and_si128(_mm_packus_epi16(lo, hi), rgbMask);
+        _mm_storeu_si128((__m128i *)(dst+i), result);
+    }
+    BlendRowPremultipliedScalar(dst+i, src+i, count-i);
+}
+
+/* Blends 16 16 bits channels (4 pixels). Alpha is read from the src pixels */
+PIXELOPS_AVX2 inline __m256i BlendChannelsAVX2(__m256i d, __m256i s)
+{
+    const __m256i c255 = _mm256_set1_epi16(255);
+    const __m256i c128 = _mm256_set1_epi16(128);
+
+    __m256i a = _mm256_shufflelo_epi16(s, _MM_SHUFFLE(3,3,3,3));
+    a = _mm256_shufflehi_epi16(a, _MM_SHUFFLE(3,3,3,3));
+    __m256i ia = _mm256_sub_epi16(c255, a);
+
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, ia));
+    x = _mm256_add_epi16(x, c128);
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+/**
+ * Blends count src pixels over dst. 8 pixels per iteration
+ * Unpack and pack both work per 128 bits lane, so pixel order is kept
+ */
+PIXELOPS_AVX2 inline void BlendRowAVX2(unsigned int *dst, const unsigned int *src, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i rgbMask = _mm256_set1_epi32(0x00ffffff);
+
+    int i = 0;
+    for (; i+8 <= count; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src+i));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst+i));
+
+        __m256i lo = BlendChannelsAVX2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero));
+        __m256i hi = BlendChannelsAVX2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero));
+
+        __m256i result = _mm256_and_si256(_mm256_packus_epi16(lo, hi), rgbMask);
+        _mm256_storeu_si256((__m256i *)(dst+i), result);
+    }
+    BlendRowSSE2(dst+i, src+i, count-i);
+}
+
+/* Blends 16 16 bits premultiplied channels (4 pixels). Alpha is read from the src pixels */
+PIXELOPS_AVX2 inline __m256i BlendChannelsPremultipliedAVX2(__m256i d, __m256i s)
+{
+    const __m256i c255 = _mm256_set1_epi16(255);
+    const __m256i c128 = _mm256_set1_epi16(128);
+
+    __m256i a = _mm256_shufflelo_epi16(s, _MM_SHUFFLE(3,3,3,3));
+    a = _mm256_shufflehi_epi16(a, _MM_SHUFFLE(3,3,3,3));
+    __m256i ia = _mm256_sub_epi16(c255, a);
+
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(d, ia), c128);
+    x = _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+    return _mm256_add_epi16(s, x);
+}
+
+/* Blends count premultiplied src pixels over dst. 8 pixels per iteration */
+PIXELOPS_AVX2 inline void BlendRowPremultipliedAVX2(unsigned int *dst, const unsigned int *src, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i rgbMask = _mm256_set1_epi32(0x00ffffff);
+
+    int i = 0;
+    for (; i+8 <= count; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src+i));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst+i));
+
+        __m256i lo = BlendChannelsPremultipliedAVX2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero));
+        __m256i hi = BlendChannelsPremultipliedAVX2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero));
+
+        __m256i result = _mm256_and_si256(_mm256_packus_epi16(lo, hi), rgbMask);
+        _mm256_storeu_si256((__m256i *)(dst+i), result);
+    }
+    BlendRowPremultipliedSSE2(dst+i, src+i, count-i);
+}
+#endif
+
+typedef void (*BlendRowFunc)(unsigned int *dst, const unsigned int *src, int count);
+
+/* Returns the blending function written for a given kernel */
+inline BlendRowFunc GetBlendRow(PixelKernel k)
+{
+#ifdef PIXELOPS_X86
+    if (k == kKernelAVX2) return BlendRowAVX2;
+    if (k == kKernelSSE2) return BlendRowSSE2;
+#endif
+    return BlendRowScalar;
+}
+
+/* Blends count src pixels over dst with the fastest kernel available */
+inline void BlendRow(unsigned int *dst, const unsigned int *src, int count)
+{
+    static BlendRowFunc blend = GetBlendRow(BestPixelKernel());
+    blend(dst, src, count);
+}
+
+/* Returns the premultiplied blending function written for a given kernel */
+inline BlendRowFunc GetBlendRowPremultiplied(PixelKernel k)
+{
+#ifdef PIXELOPS_X86
+    if (k == kKernelAVX2) return BlendRowPremultipliedAVX2;
+    if (k == kKernelSSE2) return BlendRowPremultipliedSSE2;
+#endif
+    return BlendRowPremultipliedScalar;
+}
+
+/* Blends count premultiplied src pixels over dst with the fastest kernel available */
+inline void BlendRowPremultiplied(unsigned int *dst, const unsigned int *src, int count)
+{
+    static BlendRowFunc blend = GetBlendRowPremultiplied(BestPixelKernel());
+    blend(dst, src, count);
+}
+
+/* Copies count opaque src pixels to dst. Simple enough for the compiler to vectorize */
+inline void CopyRowOpaque(unsigned int *dst, const unsigned int *src, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = src[i] & 0xffffff;
+}
+
+//==============================================================================
+// Fills
+// Rows are filled with wide unaligned stores. Streaming fills use non-temporal
+// stores, which skip the cache: they are meant for full buffer clears and must
+// be followed by a FillFence before the pixels are read from another thread
+
+/* Fills count pixels with color. Scalar version */
+inline void FillRowScalar(unsigned int *dst, unsigned int color, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = color;
+}
+
+#ifdef PIXELOPS_X86
+/* Fills count pixels with color. 16 pixels per iteration */
+inline void FillRowSSE2(unsigned int *dst, unsigned int color, int count)
+{
+    const __m128i c = _mm_set1_epi32((int)color);
+
+    int i = 0;
+    for (; i+16 <= count; i += 16)
+    {
+        _mm_storeu_si128((__m128i *)(dst+i), c);
+        _mm_storeu_si128((__m128i *)(dst+i+4), c);
+        _mm_storeu_si128((__m128i *)(dst+i+8), c);
+        _mm_storeu_si128((__m128i *)(dst+i+12), c);
+    }
+    for (; i+4 <= count; i += 4)
+        _mm_storeu_si128((__m128i *)(dst+i), c);
+    FillRowScalar(dst+i, color, count-i);
+}
+
+/* Fills count pixels with color using non-temporal stores. 4 pixels per iteration */
+inline void FillRowStreamSSE2(unsigned int *dst, unsigned int color, int count)
+{
+    const __m128i c = _mm_set1_epi32((int)color);
+
+    // Non-temporal stores need 16 bytes aligned addresses
+    int i = 0;
+    for (; i < count && ((size_t)(dst+i) & 15); i++)
+        dst[i] = color;
+    for (; i+4 <= count; i += 4)
+        _mm_stream_si128((__m128i *)(dst+i), c);
+    FillRowScalar(dst+i, color, count-i);
+}
+
+/* Fills count pixels with color. 32 pixels per iteration */
+PIXELOPS_AVX2 inline void FillRowAVX2(unsigned int *dst, unsigned int color, int count)
+{
+    const __m256i c = _mm256_set1_epi32((int)color);
+
+    int i = 0;
+    for (; i+32 <= count; i += 32)
+    {
+        _mm256_storeu_si256((__m256i *)(dst+i), c);
+        _mm256_storeu_si256((__m256i *)(dst+i+8), c);
+        _mm256_storeu_si256((__m256i *)(dst+i+16), c);
+        _mm256_storeu_si256((__m256i *)(dst+i+24), c);
+    }
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_si256((__m256i *)(dst+i), c);
+    FillRowSSE2(dst+i, color, count-i);
+}
+
+/* Fills count pixels with color using non-temporal stores. 8 pixels per iteration */
+PIXELOPS_AVX2 inline void FillRowStreamAVX2(unsigned int *dst, unsigned int color, int count)
+{
+    const __m256i c = _mm256_set1_epi32((int)color);
+
+    // Non-temporal stores need 32 bytes aligned addresses
+    int i = 0;
+    for (; i < count && ((size_t)(dst+i) & 31); i++)
+        dst[i] = color;
+    for (; i+8 <= count; i += 8)
+        _mm256_stream_si256((__m256i *)(dst+i), c);
+    FillRowScalar(dst+i, color, count-i);
+}
+#endif
+
+typedef void (*FillRowFunc)(unsigned int *dst, unsigned int color, int count);
+
+/* Returns the fill function written for a given kernel */
+inline FillRowFunc GetFillRow(PixelKernel k)
+{
+#ifdef PIXELOPS_X86
+    if (k == kKernelAVX2) return FillRowAVX2;
+    if (k == kKernelSSE2) return FillRowSSE2;
+#endif
+    return FillRowScalar;
+}
+
+/* Returns the streaming fill function written for a given kernel */
+inline FillRowFunc GetFillRowStream(PixelKernel k)
+{
+#ifdef PIXELOPS_X86
+    if (k == kKernelAVX2) return FillRowStreamAVX2;
+    if (k == kKernelSSE2) return FillRowStreamSSE2;
+#endif
+    return FillRowScalar;
+}
+
+/* Fills count pixels with color with the fastest kernel available */
+inline void FillRow(unsigned int *dst, unsigned int color, int count)
+{
+    static FillRowFunc fill = GetFillRow(BestPixelKernel());
+    fill(dst, color, count);
+}
+
+/* Fills count pixels with color with non-temporal stores of the fastest kernel available */
+inline void FillRowStream(unsigned int *dst, unsigned int color, int count)
+{
+    static FillRowFunc fill = GetFillRowStream(BestPixelKernel());
+    fill(dst, color, count);
+}
+
+/* Orders the non-temporal stores made before it. Called once a streaming fill is done */
+inline void FillFence()
+{
+#ifdef PIXELOPS_X86
+    _mm_sfence();
+#endif
+}
+
+//==============================================================================
+// Pixel formats
+
+/* Returns a straight alpha BGRA pixel with its color multiplied by its alpha */
+inline unsigned int PremultiplyPixel(unsigned int pixel)
+{
+    unsigned int a = pixel >> 24;
+
+    unsigned int rb = (pixel & 0xff00ff)*a + 0x800080;
+    rb = ((rb + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+
+    unsigned int g = ((pixel >> 8) & 0xff)*a + 0x80;
+    g = (g + (g >> 8)) >> 8;
+
+    return rb | (g << 8) | (a << 24);
+}
+
+//==============================================================================
+// Swizzling
+// Decoded images hold RGBA pixels, which are turned in place into the BGRA
+// pixels of the window buffer by swapping their red and blue channels
+
+/* Swaps the red and blue channels of count pixels. Scalar version */
+inline void SwizzleRowScalar(unsigned int *pixels, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        unsigned int p = pixels[i];
+        pixels[i] = (p & 0xff00ff00) | ((p >> 16) & 0xff) | ((p & 0xff) << 16);
+    }
+}
+
+#ifdef PIXELOPS_X86
+/* Swaps the red and blue channels of count pixels. 4 pixels per iteration */
+inline void SwizzleRowSSE2(unsigned int *pixels, int count)
+{
+    const __m128i agMask = _mm_set1_epi32((int)0xff00ff00);
+    const __m128i lowMask = _mm_set1_epi32(0xff);
+
+    // SSE2 has no byte shuffle, so both channels are moved with shifts
+    int i = 0;
+    for (; i+4 <= count; i += 4)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(pixels+i));
+        __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), lowMask);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(p, lowMask), 16);
+        p = _mm_or_si128(_mm_and_si128(p, agMask), _mm_or_si128(r, b));
+        _mm_storeu_si128((__m128i *)(pixels+i), p);
+    }
+    SwizzleRowScalar(pixels+i, count-i);
+}
+
+/* Swaps the red and blue channels of count pixels. 16 pixels per iteration */
+PIXELOPS_AVX2 inline void SwizzleRowAVX2(unsigned int *pixels, int count)
+{
+    const __m256i order = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    int i = 0;
+    for (; i+16 <= count; i += 16)
+    {
+        __m256i p0 = _mm256_loadu_si256((const __m256i *)(pixels+i));
+        __m256i p1 = _mm256_loadu_si256((const __m256i *)(pixels+i+8));
+        _mm256_storeu_si256((__m256i *)(pixels+i), _mm256_shuffle_epi8(p0, order));
+        _mm256_storeu_si256((__m256i *)(pixels+i+8), _mm256_shuffle_epi8(p1, order));
+    }
+    for (; i+8 <= count; i += 8)
+    {
+        __m256i p = _mm256_loadu_si256((const __m256i *)(pixels+i));
+        _mm256_storeu_si256((__m256i *)(pixels+i), _mm256_shuffle_epi8(p, order));
+    }
+    SwizzleRowScalar(pixels+i, count-i);
+}
+#endif
+
+typedef void (*SwizzleRowFunc)(unsigned int *pixels, int count);
+
+/* Returns the swizzling function written for a given kernel */
+inline SwizzleRowFunc GetSwizzleRow(PixelKernel k)
+{
+#ifdef PIXELOPS_X86
+    if (k == kKernelAVX2) return SwizzleRowAVX2;
+    if (k == kKernelSSE2) return SwizzleRowSSE2;
+#endif
+    return SwizzleRowScalar;
+}
+
+/* Turns count RGBA pixels into BGRA pixels with the fastest kernel available */
+inline void SwizzleRow(unsigned int *pixels, int count)
+{
+    static SwizzleRowFunc swizzle = GetSwizzleRow(BestPixelKernel());
+    swizzle(pixels, count);
+}
@@ -0,0 +1,62 @@
+/**
+ * @file Profiler.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines a scoped zone profiler
+ * Zones are timed with PROFILE_ZONE and recorded in a ring buffer per thread,
+ * then exported as a Chrome trace that can be opened in chrome://tracing or Perfetto
+ * Zones are compiled out unless PROFILER_ENABLED is defined
+ */
+
+#pragma once
+#include <chrono>
+
+//==============================================================================
+// Zone recording
+
+/* Returns the profiler clock in ns */
+inline long long ProfilerNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Records a zone in the calling thread's ring buffer
+ * Takes a name that must outlive the profiler, usually a string literal
+ * When the buffer is full, the oldest zones are overwritten
+ */
+void RecordZone(const char *name, long long start, long long end);
+
+/**
+ * Writes every recorded zone to a Chrome trace event JSON file
+ * Must be called while no zone is being recorded, between frames or on exit
+ * Returns false if the file can't be written
+ */
+bool ExportChromeTrace(const char *filePath);
+
+/* Forgets every recorded zone. Must be called while no zone is being recorded */
+void ClearZones();
+
+// Times the scope it is declared in
+class ProfileZone
+{
+private:
+    const char *_name;      // zone name
+    long long _start;       // time the scope was entered
+
+public:
+    ProfileZone(const char *name) : _name(name), _start(ProfilerNow()) {}
+    ~ProfileZone() { RecordZone(_name, _start, ProfilerNow()); }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef PROFILER_ENABLED
+/* Times the rest of the current scope under name */
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
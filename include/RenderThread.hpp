@@ -0,0 +1,89 @@
+/**
+ * @file RenderThread.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the RenderThread class
+ * It rasterizes frames on its own thread, so that the game records frame N+1 while
+ * frame N is rasterized into one of 2 or 3 rotating pixel buffers.
+ * Recorded frames and completed buffers are handed over through swap chains: the game
+ * never waits for the render thread, and the render thread only waits for the window
+ * when there are 2 buffers
+ */
+
+#pragma once
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#include "Renderer.hpp"
+#include "SwapChain.hpp"
+
+// A frame recorded by the game, waiting to be rasterized
+struct RecordedFrame
+{
+    std::vector<DrawCommand> commands;      // draws of the frame, in order
+    int width, height;                      // dimensions of the buffer the draws were made for
+};
+
+// A pixel buffer the render thread rasterizes into
+struct RenderTarget
+{
+    WinBuffer buffer;                       // buffer presented once complete
+    std::vector<unsigned int> pixels;       // storage of the buffer
+};
+
+// Render thread statistics, since it started
+struct RenderThreadStats
+{
+    int submitted;                          // frames recorded by the game
+    int dropped;                            // recorded frames replaced by a newer one before being rasterized
+    int rasterized;                         // frames rasterized
+    int presented;                          // completed buffers taken by the window
+    float raster;                           // average time spent rasterizing a frame, in ms
+};
+
+//==============================================================================
+// RenderThread class
+class RenderThread
+{
+private:
+    Renderer *_renderer;                    // records the frames and rasterizes them
+    SwapChain<RecordedFrame> _frames;       // recorded frames, from the game to the render thread
+    SwapChain<RenderTarget> _targets;       // rasterized buffers, from the render thread to the window
+    std::thread _thread;                    // render thread
+    std::atomic<bool> _running;             // tells the render thread to keep going
+    std::atomic<long long> _rasterTime;     // total time spent rasterizing, in microseconds
+    int _presented = 0;                     // completed buffers taken by the window
+    bool _dropFrames;                       // if the game runs ahead of the render thread, dropping frames
+
+    /* Rasterizes recorded frames until stopped. Run by the render thread */
+    void Run();
+
+public:
+    /**
+     * Constructor
+     * Takes the renderer, which must be binning, and the number of pixel buffers: 2 or 3
+     * Enables the renderer's pipelining mode and starts the render thread
+     * Without dropFrames, Submit waits for the render thread to take the previous frame and
+     * TakeCompletedBuffer for it to be completed: every frame is presented, one frame behind the game.
+     * Used when frames aren't paced to real time
+     */
+    RenderThread(Renderer *renderer, int bufferCount = 3, bool dropFrames = true);
+    /* Stops the render thread and disables the renderer's pipelining mode */
+    ~RenderThread();
+
+    /* Hands the frame recorded by the renderer to the render thread. Called after Renderer::EndFrame */
+    void Submit();
+    /**
+     * Returns the latest completed buffer, or null if it was already returned
+     * The buffer isn't written until a later call returns another one
+     */
+    const WinBuffer *TakeCompletedBuffer();
+
+    /* Returns the statistics of the render thread */
+    RenderThreadStats GetStats() const;
+    /* Writes a summary of the statistics */
+    void Report(FILE *file) const;
+};
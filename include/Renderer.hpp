@@ -9,7 +9,7 @@
 
 #pragma once
 
-#include <Windows.h>
+#include <unordered_map>
 #include <vector>
 
 #include "Window.hpp"
@@ -23,31 +23,140 @@ struct Rect;
 struct Text;
 struct Font;
 
+class ThreadPool;
+
 #define SWAP(a, b) do { auto temp = a; a = b; b = temp; } while(0)
 
+//==============================================================================
+// Draw commands
+
+// The different types of draw commands
+enum DrawCommandType
+{
+    kCommandClear,
+    kCommandRect,
+    kCommandRoundedRect,
+    kCommandBlit,
+};
+
+// A draw recorded by the Renderer
+struct DrawCommand
+{
+    int type;               // command type
+    ScreenRect rect;        // screen rect covered by the draw, before clipping
+    unsigned int color;     // fill color of clears and rects
+    int radius;             // corner radius of rounded rects
+    bool antialiased;       // if the corners of rounded rects are anti-aliased
+    Bitmap img;             // source image of blits
+    ScreenRect src;         // source rect of blits
+    bool reversed;          // if the source of a blit is mirrored
+};
+
+// The layers of retained draws, from back to front
+enum DrawLayer
+{
+    kLayerRects,
+    kLayerLastObjects,      // objects flagged with lastLayer, drawn behind the others
+    kLayerObjects,
+    kLayerText,
+    kLayerUi,
+};
+
+// Time spent by the Renderer in each phase of a frame, in ms
+struct RendererStats
+{
+    float clear;            // erasing the buffer in ClearScreen
+    float sprites;          // drawing retained rects, objects and ui in Update
+    float text;             // drawing retained texts in Update
+    float raster;           // rasterizing binned draws in EndFrame. 0 when not binning
+    int commands;           // number of draw commands submitted
+};
+
 //==============================================================================
 // Renderer class 
 class Renderer
 {
 private:
     WinBuffer *_buffer;                     // Pointer to pixel buffer
+    WinBuffer *_target;                     // Buffer being rasterized. Differs from _buffer when pipelining
     Vector2i _desiredCam = {0,0};           // Desired camera position. Used for smooth transitions
     Vector2i _cam = {0,0};                  // Current camera position
     float _transitionTime = 0;              // Time elapsed during camera transition to desired position 
+    std::vector<std::vector<unsigned int>>  // Source pixels sampled for the row being blended.
+        _scanlines;                         // One per rasterizing thread
+
+    ThreadPool *_pool = nullptr;            // Rasterizing threads. Only used when binning
+    bool _binning = false;                  // If draws are recorded and rasterized by tiles on Flush
+    std::vector<DrawCommand> _commands;     // Draws recorded since the last Flush
+    std::vector<std::vector<int>> _bins;    // Commands touching each tile, in drawing order
+    bool _pipelined = false;                // If recorded draws are kept by EndFrame for a render thread
+
+    std::vector<Sprite *> _objects;         // objects displayed on screen, sorted by position on screen
+    std::vector<Rect> _rects;               // rects displayed on screen
+    std::vector<Text> _texts;               // texts displayed on screen
+    std::vector<Sprite *> _ui;              // ui displayed on screen
+    std::vector<unsigned long long> _keys;  // sort key of each retained draw. Reused every frame
+    std::vector<unsigned long long> _sortBuffer; // radix sort scratch. Reused every frame
+    std::unordered_map<const unsigned int *, unsigned int> // material of each image drawn as an object this frame,
+        _materials;                         // numbered in the order they were first drawn
+
+    bool _trackDamage = false;              // If only the damaged parts of the buffer are cleared and presented
+    bool _damageOverlay = false;            // If the presented rects are outlined on screen
+    bool _fullRedraw = true;                // If the whole buffer is cleared and presented this frame
+    unsigned int _clearColor = 0;           // Color of the last clear
+    WinBuffer _lastBuffer = {0};            // Buffer dimensions and pixels at the last clear. Used to detect resizes
+    std::vector<ScreenRect> _damage;        // Rects drawn this frame
+    std::vector<ScreenRect> _lastDamage;    // Rects drawn last frame. Erased by this frame's clear
+    std::vector<ScreenRect> _dirty;         // Rects presented this frame
+
+    RendererStats _stats = {};              // Stats of the frame being drawn
+    RendererStats _lastStats = {};          // Stats of the last ended frame
     
+    /**
+     * Builds the sort keys of every retained draw. From the most significant bits:
+     * layer (3 bits), depth (32 bits), material (9 bits) and index in its list (20 bits)
+     * Only the first 2^20 draws of each list are keyed, the others aren't drawn
+     */
+    void BuildSortKeys();
+    /* Sorts the keys with a least significant byte first radix sort */
+    void SortKeys();
+    
+    /* Rasterizes a draw now, or records it when binning */
+    void Submit(const DrawCommand &command);
+    /* Rasterizes the part of a draw inside clip */
+    void Raster(const DrawCommand &command, ScreenRect clip, unsigned int *scanline);
+    /* Rasterizes the part of a clear or rect command inside clip */
+    void RasterFill(const DrawCommand &command, ScreenRect clip);
+    /**
+     * Rasterizes the part of a rounded rect command inside clip
+     * The span of each row is computed once from the corner circles, then filled
+     */
+    void RasterRoundedRect(const DrawCommand &command, ScreenRect clip);
+    /**
+     * Rasterizes the part of a blit command inside clip
+     * Source texels are walked with 16.16 fixed-point steps computed once per call
+     * Transparent spans of the image are skipped and opaque ones copied without blending
+     * Premultiplied images are blended with a single multiply-add per channel
+     */
+    void RasterBlit(const DrawCommand &command, ScreenRect clip, unsigned int *scanline);
+
     /* Draws text on screen */
     void PrintText(Text text);
+    /**
+     * Draws the source rect of an image stretched over the screen rect [x0,x1[ x [y0,y1[
+     * Shared by DrawSprite and DrawLetter
+     */
+    void BlitScaled(const Bitmap &img, int srcX, int srcY, int srcW, int srcH, 
+        int x0, int y0, int x1, int y1, bool reversed);
     /* Draws a letter on screen */
     void DrawLetter(Font *font, int index, Vector2i pos, Vector2i hSize);
-    /* Draws a rectangle with rounded borders */
-    void DrawRoundedRect(Vector2i pos, Vector2i hSize, int radius, unsigned int color);
 
 public:
     /**
      * Constructor
-     * Takes a window instance
+     * Takes the pixel buffer of a window, or of a headless window
      */
-    Renderer(Window win);
+    Renderer(WinBuffer *buffer);
     ~Renderer();
     
     /**
@@ -55,6 +164,12 @@ public:
      * Takes it's position, half size and color
      */
     void DrawRect(Vector2i pos, Vector2i hSize, unsigned int color); 
+    /**
+     * Draws a rectangle with rounded borders
+     * Takes it's position, half size, corner radius and color
+     * Corners can also be anti-aliased
+     */
+    void DrawRoundedRect(Vector2i pos, Vector2i hSize, int radius, unsigned int color, bool antialiased=false);
     /* Fills the screen with color */
     void ClearScreen(unsigned int color); 
     /**
@@ -67,6 +182,49 @@ public:
     /* Updates the pixel buffer */
     void Update(float dt);
 
+    /**
+     * Enables the binning mode
+     * Draws are then recorded, and rasterized by screen tiles on threadCount threads by Flush.
+     * Draws touching a tile are rasterized in the order they were made
+     */
+    void EnableBinning(int threadCount);
+    /* Disables the binning mode. Draws are rasterized as soon as they are made */
+    void DisableBinning();
+    /* Rasterizes the draws recorded since the last call. Does nothing when not binning */
+    void Flush();
+    /* Returns the rasterizing threads. Can run other work between frames. Null when not binning */
+    ThreadPool *GetThreadPool() const;
+
+    /**
+     * Enables the pipelining mode. Binning must be enabled first
+     * Flush and EndFrame then keep the recorded draws, which TakeCommands hands to a render
+     * thread calling Rasterize. Every frame is fully redrawn, as each one lands in another buffer
+     * Binning must not be changed while a render thread is running
+     */
+    void EnablePipelining(bool enabled);
+    /* Moves the draws recorded since the last call into commands. Used when pipelining */
+    void TakeCommands(std::vector<DrawCommand> &commands);
+    /**
+     * Rasterizes commands into buffer by screen tiles, on the binning threads
+     * Only touches the rasterizing state: can run on a render thread while the next frame is recorded
+     */
+    void Rasterize(const std::vector<DrawCommand> &commands, WinBuffer *buffer);
+
+    /**
+     * Enables damage tracking
+     * Each draw then reports its bounds: ClearScreen only erases what was drawn last frame
+     * and GetDirtyRects only returns what changed since last frame
+     */
+    void EnableDamageTracking(bool enabled);
+    /* Outlines the dirty rects on screen. Used to debug damage tracking */
+    void SetDamageOverlay(bool enabled);
+    /* Rasterizes the frame and computes its dirty rects. Called once the frame is drawn */
+    void EndFrame();
+    /* Returns the rects of the buffer that changed this frame */
+    const std::vector<ScreenRect> &GetDirtyRects() const;
+    /* Returns the time spent in each phase of the last ended frame */
+    const RendererStats &GetStats() const;
+
     /* Sets camera desired position */
     void TranslateCamera(Vector2i u);
     /* Returns current camera position */
@@ -77,11 +235,19 @@ public:
     /* Returns the pixel buffer's height */
     int GetBufferHeight() const;
 
-    std::vector<Sprite *> objectsToDraw;    // vector of all objects displayed on screen
-    std::vector<Rect> rectsToDraw;          // vector of all rects displayed on screen
-    std::vector<Text> textToDraw;           // vector of each text displayed on screen
-    std::vector<Sprite *> uiToDraw;         // vector of all ui displayed on screen
-    
-    /* Sorts objects displayed by position on screen */
-    void SortObjects();
+    /**
+     * Adds an object drawn every frame
+     * Objects are drawn back to front by their position on ground
+     */
+    void AddObject(Sprite *object);
+    /* Adds a rect drawn every frame behind the objects */
+    void AddRect(Rect rect);
+    /* Adds a text drawn every frame over the objects */
+    void AddText(Text text);
+    /* Adds an ui sprite drawn every frame over everything else */
+    void AddUi(Sprite *ui);
+    /* Stops drawing an object or ui sprite */
+    void RemoveSprite(Sprite *sprite);
+    /* Removes every retained object, rect, text and ui sprite */
+    void ClearDrawLists();
 };
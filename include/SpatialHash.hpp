@@ -0,0 +1,60 @@
+/**
+ * @file SpatialHash.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the SpatialHash class
+ * It is used as a collision broad-phase: boxes are inserted in the cells of a
+ * uniform grid they overlap, and a query only returns the ids found in the
+ * cells of its own box. The grid is unbounded, its cells are hashed in a fixed
+ * number of buckets
+ */
+
+#pragma once
+#include <vector>
+#include "Vector.hpp"
+
+// An id inserted in a bucket
+struct SpatialEntry
+{
+    int id;                 // id given to Insert
+    int next;               // next entry of the same bucket. -1 at the end of the bucket
+};
+
+//==============================================================================
+// SpatialHash class
+class SpatialHash
+{
+private:
+    float _cellSize;                        // width and height of a cell
+    std::vector<int> _buckets;              // first entry of each bucket. -1 if the bucket is empty
+    std::vector<SpatialEntry> _entries;     // entries of every bucket
+    std::vector<int> _marks;                // last query that returned each id
+    int _query = 0;                         // number of queries since the ids were last cleared
+
+    /* Returns the bucket of a cell */
+    int GetBucket(int cellX, int cellY) const;
+    /* Returns the range of cells overlapped by a box */
+    void GetCells(Vector2f pos, Vector2f hSize, int &xmin, int &ymin, int &xmax, int &ymax) const;
+
+public:
+    /**
+     * Constructor
+     * Takes the size of a cell, around the size of the inserted boxes, and a number of buckets
+     * The number of buckets is rounded up to a power of two
+     */
+    SpatialHash(float cellSize, int bucketCount = 4096);
+
+    /* Removes every id */
+    void Clear();
+    /**
+     * Inserts an id with a box given by it's center and half size
+     * An id can be inserted again after it moved, the old box is then still returned by queries
+     */
+    void Insert(int id, Vector2f pos, Vector2f hSize);
+    /**
+     * Adds to ids every id inserted in a cell overlapped by a box, once
+     * Ids may not overlap the box itself, they must go through a narrow-phase test
+     */
+    void Query(Vector2f pos, Vector2f hSize, std::vector<int> &ids);
+};
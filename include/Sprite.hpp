@@ -103,7 +103,7 @@ private:
 
     /* Adds tick time to the animation's frame time */
     void IncrementFrameTime(float dt) override;
-    Animation GetCurrentAnimation();
+    const Animation &GetCurrentAnimation() const;
 
 public:
     /**
@@ -111,7 +111,7 @@ public:
      * Takes a position, a scale factor and a vector of animations
      * Can also take if the image is reversed as parameter
      */
-    AnimatedSprite::AnimatedSprite(Vector2i pos, float scale, std::vector<Animation> anim, bool reversed=false); 
+    AnimatedSprite(Vector2i pos, float scale, std::vector<Animation> anim, bool reversed=false); 
 
     /* Draws the sprite on screen */
     void Draw(Renderer *r) override;
@@ -0,0 +1,112 @@
+/**
+ * @file SwapChain.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the SwapChain class
+ * It hands slots from one writing thread to one reading thread without locks.
+ * The writer fills a slot and publishes it, the reader takes the latest published slot
+ * and keeps it until it takes a newer one. A slot is never written while it is read
+ *
+ * With 3 slots neither side ever waits: the writer always finds a free slot and
+ * publishing over a slot the reader didn't take drops it. With 2 slots the writer
+ * waits for the reader to take the last published slot before writing again
+ */
+
+#pragma once
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+// SwapChain class
+template <typename T>
+class SwapChain
+{
+private:
+    // The state is a single word, so that both sides change it with one compare and swap:
+    // the latest published slot, the slot held by the reader and if the latest slot is new
+    static const unsigned int kNoSlot = 0xFF;           // no slot published or read
+    static const unsigned int kFresh = 1 << 16;         // the latest slot wasn't taken by the reader yet
+
+    std::vector<T> _slots;                      // slots handed from the writer to the reader
+    std::atomic<unsigned int> _state;           // latest slot (bits 0-7), read slot (bits 8-15) and kFresh
+    int _back = -1;                             // slot being written. Only used by the writer
+    std::atomic<int> _published;                // number of published slots
+    std::atomic<int> _dropped;                  // published slots overwritten before being read
+
+    static unsigned int Latest(unsigned int state) { return state & 0xFF; }
+    static unsigned int Read(unsigned int state) { return (state >> 8) & 0xFF; }
+
+public:
+    /* Constructor. Takes the number of slots, 2 or 3 */
+    SwapChain(int slotCount = 3)
+        : _slots((slotCount < 2) ? 2 : (slotCount > 3) ? 3 : slotCount),
+        _state(kNoSlot | kNoSlot << 8), _published(0), _dropped(0)
+    {
+    }
+
+    /**
+     * Returns a slot the writer can fill, the same one until it is published
+     * Returns null if every slot is published or read, which only happens with 2 slots
+     */
+    T *BeginWrite()
+    {
+        if (_back < 0)
+        {
+            // The reader only ever takes the latest slot, which only the writer changes:
+            // a slot free in this snapshot stays free until it is published
+            unsigned int state = _state.load(std::memory_order_acquire);
+            for (int i = 0; i < (int)_slots.size() && _back < 0; i++)
+            {
+                if ((unsigned int)i != Latest(state) && (unsigned int)i != Read(state))
+                    _back = i;
+            }
+            if (_back < 0)
+                return nullptr;
+        }
+        return &_slots[_back];
+    }
+
+    /* Publishes the slot returned by BeginWrite as the latest one */
+    void EndWrite()
+    {
+        if (_back < 0) return;
+
+        unsigned int state = _state.load(std::memory_order_relaxed);
+        unsigned int next;
+        do
+            next = (state & ~(0xFF | kFresh)) | (unsigned int)_back | kFresh;
+        while (!_state.compare_exchange_weak(state, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        if (state & kFresh)
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+        _published.fetch_add(1, std::memory_order_relaxed);
+        _back = -1;
+    }
+
+    /**
+     * Takes the latest published slot if the reader doesn't have it yet, and gives back the previous one
+     * Returns null if nothing was published since the last call
+     */
+    T *TakeLatest()
+    {
+        unsigned int state = _state.load(std::memory_order_acquire);
+        unsigned int next;
+        do
+        {
+            if (!(state & kFresh))
+                return nullptr;
+            next = Latest(state) | Latest(state) << 8;
+        }
+        while (!_state.compare_exchange_weak(state, next, std::memory_order_acq_rel, std::memory_order_acquire));
+
+        return &_slots[Latest(state)];
+    }
+
+    /* Returns true if the reader took the latest published slot, or if none was published */
+    bool IsLatestTaken() const { return !(_state.load(std::memory_order_acquire) & kFresh); }
+    /* Returns the number of published slots */
+    int GetPublishedCount() const { return _published.load(std::memory_order_relaxed); }
+    /* Returns the number of published slots that were replaced before the reader took them */
+    int GetDroppedCount() const { return _dropped.load(std::memory_order_relaxed); }
+};
@@ -76,7 +76,7 @@ static float GetWordAlignOffset(int textAlign, char *word, float size, int spaci
 /* Load font from file path. Returns Font object */
 static Font ReadFont(char *path)
 {
-    Bitmap img = ReadImage(path);
+    Bitmap img = ReadImage(path, true);
     Font result = {0};
     result.bitmap = img; 
     result.lWidth = img.width/30;
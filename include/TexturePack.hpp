@@ -0,0 +1,80 @@
+/**
+ * @file TexturePack.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the texture pack format along with the TexturePack class
+ * A texture pack holds images ready to be drawn: pixels are already swizzled,
+ * flipped and split in spans. It is built offline by tools/texpack.cpp
+ *
+ * Layout of a pack file:
+ * - a PackHeader
+ * - a PackEntry for each image
+ * - the data of each image, starting on a kPackAlignment boundary:
+ *   it's pixels, then the first span of each row plus one (height+1 ints), then it's spans
+ */
+
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "FileReader.hpp"
+
+static const unsigned int kPackMagic = 0x4b50534d;      // "MSPK"
+static const unsigned int kPackVersion = 1;             // format version
+static const unsigned int kPackAlignment = 64;          // alignment of image data in the file
+
+// Flags of a packed image
+enum PackFlags
+{
+    kPackPremultiplied = 1,         // colors are multiplied by alpha
+};
+
+// Header of a pack file
+struct PackHeader
+{
+    unsigned int magic;             // kPackMagic
+    unsigned int version;           // kPackVersion
+    unsigned int imageCount;        // number of entries following the header
+    unsigned int reserved;          // 0
+};
+
+// Index entry of a packed image
+struct PackEntry
+{
+    char path[112];                 // path of the source image, with '/' separators. Null terminated
+    unsigned long long dataOffset;  // offset of the image data from the start of the file
+    int width, height;              // image dimensions
+    unsigned int spanCount;         // number of spans of the image
+    unsigned int flags;             // PackFlags
+};
+
+//==============================================================================
+// TexturePack class
+class TexturePack
+{
+private:
+    MappedFile _file = {0};                 // mapped pack file
+    std::map<std::string, Bitmap> _images;  // views of the packed images, by path
+    std::vector<SpanTable *> _spans;        // spans of every image, copied from the file
+
+public:
+    TexturePack();
+    ~TexturePack();
+
+    /**
+     * Maps a pack file. Previously opened images are closed
+     * Returns false if the file is missing or isn't a valid pack
+     */
+    bool Open(const char *filePath);
+    /* Unmaps the pack file. Images found in it can't be used anymore */
+    void Close();
+
+    /**
+     * Finds an image by the path of it's source image
+     * Returns a view of the mapped pixels, which must not be written, or an empty Bitmap if it isn't packed
+     */
+    Bitmap Find(const char *path) const;
+    /* Returns the number of packed images */
+    int GetImageCount() const;
+};
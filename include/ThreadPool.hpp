@@ -0,0 +1,77 @@
+/**
+ * @file ThreadPool.hpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the ThreadPool class
+ * It is used to run jobs on every core of the cpu, and tasks in the background
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+// ThreadPool class
+class ThreadPool
+{
+private:
+    std::vector<std::thread> _workers;          // worker threads. The calling thread is thread 0
+    std::mutex _mutex;                          // protects the job state below
+    std::condition_variable _wake;              // wakes the workers when a job or a task is posted
+    std::condition_variable _done;              // wakes the caller when the workers are done
+    std::function<void(int, int)> _job;         // current job. Takes a job index and a thread index
+    int _jobCount = 0;                          // number of indices in the current job
+    std::atomic<int> _nextIndex;                // next job index to run
+    int _busyWorkers = 0;                       // workers still running the current job
+    unsigned int _generation = 0;               // incremented for each job posted
+    bool _stopping = false;                     // tells the workers to exit
+    std::deque<std::function<void()>> _tasks;   // background tasks waiting for a worker
+
+    /* Waits for jobs and tasks and runs them. Run by each worker */
+    void WorkerLoop(int threadIndex);
+    /* Runs job indices until there are none left */
+    void RunJobs(int threadIndex);
+
+public:
+    /**
+     * Constructor
+     * Takes the total number of threads, including the calling one
+     */
+    ThreadPool(int threadCount);
+    /* Runs the queued tasks, then stops the workers */
+    ~ThreadPool();
+
+    /**
+     * Runs job(index, thread) for every index in [0,count[ and waits for all of them
+     * The calling thread takes part in the job as thread 0
+     */
+    void ParallelFor(int count, const std::function<void(int, int)> &job);
+
+    /**
+     * Queues a task run by the first free worker, or right away if there are no workers
+     * Jobs go first: a ParallelFor only waits for the tasks workers already started
+     */
+    void Enqueue(std::function<void()> task);
+
+    /* Runs task in the background. Returns a future of it's result */
+    template <typename F>
+    std::future<decltype(std::declval<F>()())> Async(F task)
+    {
+        typedef decltype(std::declval<F>()()) Result;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(task);
+        std::future<Result> result = packaged->get_future();
+        Enqueue([packaged] { (*packaged)(); });
+        return result;
+    }
+
+    /* Returns the total number of threads, including the calling one */
+    int GetThreadCount() const;
+};
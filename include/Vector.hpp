@@ -138,4 +138,15 @@ inline float Distance(Vector2i a, Vector2i b)
     float x = Square((float)(b.x-a.x));
     float y = Square((float)(b.y-a.y));
     return sqrtf(x + y);
-}
\ No newline at end of file
+}
+/* Returns a vector rounded to the nearest integers */
+inline Vector2i ToVector2i(Vector2f u)
+{
+    return {(int)floorf(u.x+.5f), (int)floorf(u.y+.5f)};
+}
+
+/* Linearly interpolate between vectors a and b by w */
+inline Vector2f Lerp(Vector2f a, Vector2f b, float w)
+{
+    return {Lerp(a.x, b.x, w), Lerp(a.y, b.y, w)};
+}
@@ -5,12 +5,17 @@
  * 
  * This file defines the Window class along with the WinBuffer struct
  * It is used to display a Window
+ * The Window class is only available on Windows, see Headless.hpp for other platforms
  */
 
 #pragma once
+#ifdef _WIN32
 #include <Windows.h>
+#endif
+#include <vector>
 
 #include "Input.hpp"
+#include "FramePacer.hpp"
 
 //==============================================================================
 // The window pixel buffer
@@ -18,9 +23,18 @@ struct WinBuffer
 {
     int width, height;      // width and height of the screen
     unsigned int *pixels;   // color of each pixel
+#ifdef _WIN32
     BITMAPINFO info;        // WinApi Bitmap info
+#endif
 };
 
+// A rectangle of buffer pixels going from (x0,y0) to (x1,y1), excluded
+struct ScreenRect
+{
+    int x0, y0, x1, y1;
+};
+
+#ifdef _WIN32
 //==============================================================================
 // Window class
 class Window
@@ -29,10 +43,8 @@ private:
     static HWND _window;                    // WinApi window
     HDC _deviceContext;                     // used to display buffer on screen
 
-    LARGE_INTEGER _lastCounter;             // last frame time counter. used to calculate framerate
-    static float _freqCounter;              // time check frequency. used to calculate framerate
-    float _targetFt = 0.01666f;             // ideal frame time. used to lock the framerate
-    float _lastFt;                          // last frame's time
+    FramePacer _pacer;                      // locks the framerate, 60 fps by default
+    float _lastFt = 0;                      // last frame's time
     static bool _active;                    // used to stop activities when the window isn't active
 
     static bool _running;                   // used to stop the program
@@ -41,10 +53,11 @@ private:
             WPARAM wParam, LPARAM lParam);
 
     static WinBuffer _buffer;               // pixel buffer
+    static const WinBuffer *_presented;     // last buffer presented from a render thread. Null if there is none
     static unsigned int _backgroundColor;   // defines the color used when stretching the window
-    
-    /* Returns the elapsed time since last frame */
-    float GetElapsedTime() const;
+
+    /* Stretches the dirty rects of a buffer over the window */
+    void Present(const WinBuffer &buffer, const std::vector<ScreenRect> &dirtyRects);
 
 public:
     /**
@@ -58,6 +71,15 @@ public:
     void HandleMessages();
     /* Displays frame on framerate */ 
     void ProcessFrame(); 
+    /* Displays the dirty rects of the frame on framerate */
+    void ProcessFrame(const std::vector<ScreenRect> &dirtyRects);
+    /**
+     * Displays a buffer completed by a render thread on framerate
+     * Null keeps the previous one on screen. The buffer must stay untouched until the next one
+     */
+    void ProcessFrame(const WinBuffer *buffer);
+    /* Forgets the buffer presented from a render thread. Called before the render thread is destroyed */
+    void StopPresenting();
 
     /* Sets background color */
     void SetBackgroundColor(unsigned int color) const;
@@ -68,6 +90,8 @@ public:
     HWND *GetWindow() const; 
     /* Returns a pointer to the pixel buffer */
     WinBuffer *GetBuffer() const;
+    /* Returns the frame pacer. Used to set the target framerate and read pacing statistics */
+    FramePacer &GetPacer();
 
     /** Returns last frame time. 
      * Can be used as a delta time to lock movement to framerate 
@@ -75,4 +99,5 @@ public:
     float GetFt() const;
 
     Input input;    // user input
-};
\ No newline at end of file
+};
+#endif
\ No newline at end of file
@@ -9,16 +9,26 @@
 #include "Animation.hpp"
 #include "Vector.hpp"
 
-Animation::Animation(const char *folderPath, int fps, bool looping, bool default)
-    : _fps(fps), _looping(looping), _returnToDefault(default)
+Animation::Animation(AssetCache *cache, const char *folderPath, int fps, bool looping, bool returnToDefault, 
+    ThreadPool *pool)
+    : _fps(fps), _looping(looping), _returnToDefault(returnToDefault)
 {
-    for (int i = 0; i < NumberOfFiles(folderPath); i++)
+    int frameCount = NumberOfFiles(folderPath);
+    std::vector<std::string> paths;
+    for (int i = 0; i < frameCount; i++)
     {
         std::stringstream file;
-        file << folderPath << "\\" << i << ".png";
-        _images.push_back(ReadImage(file.str().c_str()));
+        file << folderPath << "/" << i << ".png";
+        paths.push_back(file.str());
     }
-    _imageDimensions = {_images.at(0).width, _images.at(0).height};
+
+    std::vector<const char *> files;
+    for (const std::string &path : paths)
+        files.push_back(path.c_str());
+    _images = cache->LoadAll(files, true, pool);
+
+    Bitmap first = _images.at(0).Get();
+    _imageDimensions = {first.width, first.height};
     _frameLength = _images.size();
 }
 
@@ -51,7 +61,7 @@ Vector2i Animation::GetImageDimensions() const
     return _imageDimensions;
 }
 
-Bitmap Animation::GetImage(int index)
+Bitmap Animation::GetImage(int index) const
 {
-    return _images.at(index);
+    return _images.at(index).Get();
 }
\ No newline at end of file
@@ -0,0 +1,223 @@
+/**
+ * @file assetcache.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the AssetCache and ImageHandle classes' implementation
+ */
+
+#include "AssetCache.hpp"
+#include "ThreadPool.hpp"
+#include "TexturePack.hpp"
+#include "Atlas.hpp"
+#include <future>
+
+/* Returns the memory used by the pixels and spans of an image in bytes */
+static size_t ImageSize(const Bitmap &image)
+{
+    size_t size = (size_t)image.pitch*image.height*sizeof(unsigned int);
+    if (image.spans)
+        size += image.spans->rows.size()*sizeof(int) + image.spans->spans.size()*sizeof(PixelSpan);
+    return size;
+}
+
+//==============================================================================
+// ImageHandle class implementation
+
+ImageHandle::ImageHandle(AssetCache *cache, CachedImage *image)
+    : _cache(cache), _image(image)
+{
+    _image->refCount++;
+}
+
+ImageHandle::ImageHandle(const ImageHandle &other)
+    : _cache(other._cache), _image(other._image)
+{
+    if (_image)
+        _image->refCount++;
+}
+
+ImageHandle::ImageHandle(ImageHandle &&other)
+    : _cache(other._cache), _image(other._image)
+{
+    other._cache = nullptr;
+    other._image = nullptr;
+}
+
+ImageHandle &ImageHandle::operator=(const ImageHandle &other)
+{
+    // The new reference is taken first, in case both handles share the image
+    AssetCache *cache = other._cache;
+    CachedImage *image = other._image;
+    if (image)
+        image->refCount++;
+    Reset();
+    _cache = cache;
+    _image = image;
+    return *this;
+}
+
+ImageHandle &ImageHandle::operator=(ImageHandle &&other)
+{
+    if (this != &other)
+    {
+        Reset();
+        _cache = other._cache;
+        _image = other._image;
+        other._cache = nullptr;
+        other._image = nullptr;
+    }
+    return *this;
+}
+
+ImageHandle::~ImageHandle()
+{
+    Reset();
+}
+
+void ImageHandle::Reset()
+{
+    if (_image)
+        _cache->Release(_image);
+    _cache = nullptr;
+    _image = nullptr;
+}
+
+Bitmap ImageHandle::Get() const
+{
+    if (!_image)
+        return {0};
+    return _image->bitmap;
+}
+
+bool ImageHandle::IsValid() const
+{
+    return _image != nullptr;
+}
+
+//==============================================================================
+// AssetCache class implementation
+
+AssetCache::AssetCache()
+{
+}
+
+AssetCache::~AssetCache()
+{
+    for (auto &entry : _images)
+    {
+        if (entry.second->page >= 0)
+            _atlas->Remove(entry.second->page);
+        else if (entry.second->owned)
+            FreeImage(entry.second->bitmap);
+        delete entry.second;
+    }
+}
+
+ImageHandle AssetCache::Load(const char *filePath, bool premultiply)
+{
+    std::pair<std::string, bool> key(filePath, premultiply);
+    auto found = _images.find(key);
+    if (found != _images.end())
+        return ImageHandle(this, found->second);
+
+    Bitmap packed = FindPacked(filePath, premultiply);
+    if (packed.pixels)
+        return ImageHandle(this, Insert(filePath, premultiply, packed, false));
+    return ImageHandle(this, Insert(filePath, premultiply, ReadImage(filePath, premultiply), true));
+}
+
+std::vector<ImageHandle> AssetCache::LoadAll(const std::vector<const char *> &filePaths, bool premultiply, ThreadPool *pool)
+{
+    // Missing files are decoded on the pool, but the cache itself is only used by this thread
+    std::map<std::string, std::future<Bitmap>> decodes;
+    for (const char *filePath : filePaths)
+    {
+        std::string path(filePath);
+        if (!pool || _images.count(std::make_pair(path, premultiply)) || decodes.count(path) ||
+            FindPacked(filePath, premultiply).pixels)
+            continue;
+        decodes[path] = pool->Async([path, premultiply] { return ReadImage(path.c_str(), premultiply); });
+    }
+
+    for (auto &decode : decodes)
+        Insert(decode.first.c_str(), premultiply, decode.second.get(), true);
+
+    std::vector<ImageHandle> handles;
+    for (const char *filePath : filePaths)
+        handles.push_back(Load(filePath, premultiply));
+    return handles;
+}
+
+CachedImage *AssetCache::Insert(const char *filePath, bool premultiply, Bitmap bitmap, bool owned)
+{
+    CachedImage *image = new CachedImage;
+    image->path = filePath;
+    image->premultiplied = premultiply;
+    image->bitmap = bitmap;
+    image->owned = owned;
+    image->page = -1;
+    image->refCount = 0;
+    _images[std::make_pair(image->path, premultiply)] = image;
+    if (owned)
+    {
+        if (_atlas)
+            image->bitmap = _atlas->Add(bitmap, &image->page);
+        else
+            _residentSize += ImageSize(image->bitmap);
+        _decodeCount++;
+    }
+    return image;
+}
+
+Bitmap AssetCache::FindPacked(const char *filePath, bool premultiply) const
+{
+    if (!_pack)
+        return {0};
+
+    Bitmap image = _pack->Find(filePath);
+    if (image.premultiplied != premultiply)
+        return {0};
+    return image;
+}
+
+void AssetCache::SetPack(const TexturePack *pack)
+{
+    _pack = pack;
+}
+
+void AssetCache::SetAtlas(TextureAtlas *atlas)
+{
+    _atlas = atlas;
+}
+
+void AssetCache::Release(CachedImage *image)
+{
+    if (--image->refCount > 0)
+        return;
+
+    _images.erase(std::make_pair(image->path, image->premultiplied));
+    if (image->page >= 0)
+        _atlas->Remove(image->page);
+    else if (image->owned)
+    {
+        _residentSize -= ImageSize(image->bitmap);
+        FreeImage(image->bitmap);
+    }
+    delete image;
+}
+
+int AssetCache::GetImageCount() const
+{
+    return (int)_images.size();
+}
+
+size_t AssetCache::GetResidentSize() const
+{
+    return _residentSize + (_atlas ? _atlas->GetMemorySize() : 0);
+}
+
+int AssetCache::GetDecodeCount() const
+{
+    return _decodeCount;
+}
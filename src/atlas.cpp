@@ -0,0 +1,165 @@
+/**
+ * @file atlas.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the TextureAtlas class's implementation
+ */
+
+#include "Atlas.hpp"
+#include "Math.hpp"
+#include <algorithm>
+#include <string.h>
+
+TextureAtlas::TextureAtlas(int pageWidth, int pageHeight)
+    : _pageWidth(pageWidth), _pageHeight(pageHeight)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    for (AtlasPage *page : _pages)
+    {
+        if (!page) continue;
+        for (SpanTable *spans : page->spans)
+            delete spans;
+        delete page;
+    }
+}
+
+bool TextureAtlas::FindPosition(const AtlasPage *page, int width, int height, int &x, int &y, int &segment) const
+{
+    const std::vector<SkylineSegment> &skyline = page->skyline;
+    bool found = false;
+    for (int i = 0; i < (int)skyline.size() && skyline[i].x + width <= page->width; i++)
+    {
+        // The rect lies on the highest segment it spans
+        int top = 0;
+        for (int j = i; j < (int)skyline.size() && skyline[j].x < skyline[i].x + width; j++)
+            top = max(top, skyline[j].y);
+
+        if (top + height <= page->height && (!found || top < y))
+        {
+            found = true;
+            x = skyline[i].x;
+            y = top;
+            segment = i;
+        }
+    }
+    return found;
+}
+
+void TextureAtlas::AddToSkyline(AtlasPage *page, int segment, int x, int y, int width, int height)
+{
+    std::vector<SkylineSegment> &skyline = page->skyline;
+    skyline.insert(skyline.begin()+segment, {x, y+height, width});
+
+    // Segments under the rect are shortened or removed
+    int i = segment+1;
+    while (i < (int)skyline.size() && skyline[i].x < x+width)
+    {
+        int overlap = x+width - skyline[i].x;
+        if (overlap < skyline[i].width)
+        {
+            skyline[i].x += overlap;
+            skyline[i].width -= overlap;
+            break;
+        }
+        skyline.erase(skyline.begin()+i);
+    }
+
+    // Neighbours of the same height are merged
+    for (i = 0; i+1 < (int)skyline.size(); )
+    {
+        if (skyline[i].y == skyline[i+1].y)
+        {
+            skyline[i].width += skyline[i+1].width;
+            skyline.erase(skyline.begin()+i+1);
+        }
+        else i++;
+    }
+}
+
+Bitmap TextureAtlas::Add(Bitmap image, int *pageIndex)
+{
+    Bitmap view = image;
+    if (pageIndex)
+        *pageIndex = -1;
+    if (!image.pixels)
+        return view;
+
+    AtlasPage *page = 0;
+    int index = -1;
+    int x = 0, y = 0, segment = 0;
+    for (int i = 0; i < (int)_pages.size() && !page; i++)
+    {
+        if (_pages[i] && FindPosition(_pages[i], image.width, image.height, x, y, segment))
+        {
+            page = _pages[i];
+            index = i;
+        }
+    }
+
+    if (!page)
+    {
+        page = new AtlasPage;
+        page->width = max(_pageWidth, image.width);
+        page->height = max(_pageHeight, image.height);
+        page->pixels.resize((size_t)page->width*page->height);
+        page->skyline.push_back({0, 0, page->width});
+        page->imageCount = 0;
+        FindPosition(page, image.width, image.height, x, y, segment);
+
+        // Freed pages leave their index to the next new page
+        index = (int)(std::find(_pages.begin(), _pages.end(), nullptr) - _pages.begin());
+        if (index == (int)_pages.size())
+            _pages.push_back(page);
+        else
+            _pages[index] = page;
+    }
+    AddToSkyline(page, segment, x, y, image.width, image.height);
+
+    unsigned int *dst = page->pixels.data() + (size_t)y*page->width + x;
+    for (int row = 0; row < image.height; row++)
+        memcpy(dst + (size_t)row*page->width, image.pixels + (size_t)row*image.pitch, image.width*sizeof(unsigned int));
+
+    view.pixels = dst;
+    view.pitch = page->width;
+    if (image.spans)
+        page->spans.push_back(image.spans);
+    image.spans = 0;
+    FreeImage(image);
+
+    page->imageCount++;
+    if (pageIndex)
+        *pageIndex = index;
+    return view;
+}
+
+void TextureAtlas::Remove(int index)
+{
+    AtlasPage *page = _pages[index];
+    if (--page->imageCount > 0)
+        return;
+
+    for (SpanTable *spans : page->spans)
+        delete spans;
+    delete page;
+    _pages[index] = nullptr;
+}
+
+int TextureAtlas::GetPageCount() const
+{
+    return (int)(_pages.size() - std::count(_pages.begin(), _pages.end(), nullptr));
+}
+
+size_t TextureAtlas::GetMemorySize() const
+{
+    size_t size = 0;
+    for (const AtlasPage *page : _pages)
+    {
+        if (page)
+            size += page->pixels.size()*sizeof(unsigned int);
+    }
+    return size;
+}
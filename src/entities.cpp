@@ -0,0 +1,116 @@
+/**
+ * @file entities.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the EntityStore struct's implementation
+ */
+
+#include "Entities.hpp"
+
+EntityStore::EntityStore(int capacity)
+{
+    SetCapacity(capacity);
+}
+
+EntityHandle EntityStore::Add(Vector2f pos, Vector2f hSize, Vector2f velocity, int hp, Sprite *sprite)
+{
+    if (_freeSlots.empty())
+        return {-1, 0};
+
+    int slot = _freeSlots.back();
+    _freeSlots.pop_back();
+    _indices[slot] = GetCount();
+    _slots.push_back(slot);
+
+    positions.push_back(pos);
+    previousPositions.push_back(pos);
+    halfSizes.push_back(hSize);
+    velocities.push_back(velocity);
+    hitPoints.push_back(hp);
+    sprites.push_back(sprite);
+    return {slot, _generations[slot]};
+}
+
+void EntityStore::Remove(int index)
+{
+    int last = GetCount()-1;
+    int slot = _slots[index];
+    _generations[slot]++;
+    _freeSlots.push_back(slot);
+
+    _slots[index] = _slots[last];
+    _indices[_slots[index]] = index;
+    positions[index] = positions[last];
+    previousPositions[index] = previousPositions[last];
+    halfSizes[index] = halfSizes[last];
+    velocities[index] = velocities[last];
+    hitPoints[index] = hitPoints[last];
+    sprites[index] = sprites[last];
+
+    _slots.pop_back();
+    positions.pop_back();
+    previousPositions.pop_back();
+    halfSizes.pop_back();
+    velocities.pop_back();
+    hitPoints.pop_back();
+    sprites.pop_back();
+}
+
+void EntityStore::Remove(EntityHandle handle)
+{
+    int index = GetIndex(handle);
+    if (index >= 0)
+        Remove(index);
+}
+
+void EntityStore::Clear()
+{
+    while (GetCount() > 0)
+        Remove(GetCount()-1);
+}
+
+void EntityStore::SetCapacity(int capacity)
+{
+    Clear();
+    _capacity = capacity;
+    _indices.assign(capacity, -1);
+    // Generations are kept when the store shrinks, so old handles stay invalid if it grows back
+    if ((int)_generations.size() < capacity)
+        _generations.resize(capacity, 0);
+
+    // Slots are handed out from the back of the free list, lowest first
+    _freeSlots.clear();
+    for (int slot = capacity-1; slot >= 0; slot--)
+        _freeSlots.push_back(slot);
+
+    _slots.reserve(capacity);
+    positions.reserve(capacity);
+    previousPositions.reserve(capacity);
+    halfSizes.reserve(capacity);
+    velocities.reserve(capacity);
+    hitPoints.reserve(capacity);
+    sprites.reserve(capacity);
+}
+
+int EntityStore::GetIndex(EntityHandle handle) const
+{
+    if (handle.slot < 0 || handle.slot >= _capacity || _generations[handle.slot] != handle.generation)
+        return -1;
+    return _indices[handle.slot];
+}
+
+EntityHandle EntityStore::GetHandle(int index) const
+{
+    return {_slots[index], _generations[_slots[index]]};
+}
+
+int EntityStore::GetCount() const
+{
+    return (int)positions.size();
+}
+
+int EntityStore::GetCapacity() const
+{
+    return _capacity;
+}
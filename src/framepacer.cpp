@@ -0,0 +1,130 @@
+/**
+ * @file framepacer.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the FramePacer class's implementation
+ */
+
+#include "FramePacer.hpp"
+#include "Math.hpp"
+#include "Profiler.hpp"
+#include <string.h>
+#include <thread>
+#ifdef _WIN32
+#include <Windows.h>
+#include <timeapi.h>
+#endif
+
+static const double kLateWakeTolerance = .0002;    // time past a deadline still counted as on time
+
+/* Returns the time between two clock points in seconds */
+static double Seconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+FramePacer::FramePacer(float fps)
+{
+#ifdef _WIN32
+    // Sleep is only precise to the timer resolution, which is raised once for the pacer's life
+    timeBeginPeriod(1);
+#endif
+    ResetStats();
+    SetTarget(fps);
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+}
+
+float FramePacer::Wait()
+{
+    PROFILE_ZONE("FramePacer::Wait");
+    Clock::time_point now = Clock::now();
+    if (!_started)
+    {
+        // Loading may happen between the creation and the first frame, so the cadence starts here
+        _started = true;
+        _lastFrame = now;
+        _deadline = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_targetTime));
+        return (float)_targetTime;
+    }
+
+    if (_targetTime > 0)
+    {
+        if (now > _deadline)
+        {
+            _stats.missed++;
+            _deadline = now;
+        }
+        else
+        {
+            Clock::time_point wake = _deadline - std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(_spinTime));
+            if (now < wake)
+                std::this_thread::sleep_until(wake);
+            while ((now = Clock::now()) < _deadline)
+                std::this_thread::yield();
+
+            double late = Seconds(now - _deadline);
+            if (late > kLateWakeTolerance)
+            {
+                _stats.lateWakes++;
+                _stats.worstLateWake = (float)max((double)_stats.worstLateWake, late*1000);
+            }
+        }
+        _deadline += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_targetTime));
+    }
+
+    double ft = Seconds(now - _lastFrame);
+    _lastFrame = now;
+    _stats.frames++;
+    _stats.histogram[min((int)(ft*1000), kPacerBuckets-1)]++;
+    return (float)ft;
+}
+
+void FramePacer::SetTarget(float fps)
+{
+    _targetTime = (fps > 0) ? 1./fps : 0;
+    if (_started)
+        _deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_targetTime));
+}
+
+void FramePacer::SetSpinTime(float ms)
+{
+    _spinTime = max(0.f, ms)/1000.;
+}
+
+float FramePacer::GetTarget() const
+{
+    return (_targetTime > 0) ? (float)(1./_targetTime) : 0.f;
+}
+
+const PacerStats &FramePacer::GetStats() const
+{
+    return _stats;
+}
+
+void FramePacer::ResetStats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void FramePacer::Report(FILE *file) const
+{
+    fprintf(file, "%d frames paced at %.0f fps, %d missed deadlines, %d late wakes (worst %.2f ms)\n",
+        _stats.frames, GetTarget(), _stats.missed, _stats.lateWakes, _stats.worstLateWake);
+    for (int b = 0; b < kPacerBuckets; b++)
+    {
+        if (!_stats.histogram[b])
+            continue;
+        if (b == kPacerBuckets-1)
+            fprintf(file, "  >= %2d ms %8d\n", b, _stats.histogram[b]);
+        else
+            fprintf(file, "  %2d-%2d ms %8d\n", b, b+1, _stats.histogram[b]);
+    }
+}
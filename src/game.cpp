@@ -8,9 +8,13 @@
 
 #include "Game.hpp"
 #include "Math.hpp"
-#include "Bullet.hpp"
-#include "Platform.hpp"
-#include "Equation.hpp"
+#include "Entities.hpp"
+#include "SpatialHash.hpp"
+#include "Sprite.hpp"
+#include "Profiler.hpp"
+#include "TexturePack.hpp"
+#include "Atlas.hpp"
+#include <utility>
 #include <vector>
 
 Game::Game() {}
@@ -19,162 +23,343 @@ Game::~Game() {}
 //==============================================================================
 // Game variables
 
-Vector2i pos = {100,100};                   // Player position
-Vector2i hSize = {10,20};                   // Player half size
+float stepTime = 1.f/120;                   // Duration of a simulation step
+float accumulator = 0;                      // Time not simulated yet, less than a step after Update
+float maxFrameTime = .25f;                  // Longest frame simulated. Longer frames slow the game down
+float screenWidth = 1200;                   // Width of the screen. Read from the renderer by Init
+
+Vector2f pos = {100,100};                   // Player position
+Vector2f previousPos = {100,100};           // Player position at the previous step
+Vector2f hSize = {10,20};                   // Player half size
 int dir = 1;                                // Player direction
+float speed = 300;                          // Player speed in pixels per second
 
-int jumpHeight = 20;                        // Player jump height
+float jumpSpeed = 1200;                     // Player jump speed in pixels per second
 bool jumped = false;                        // If player is jumping
 bool onGround = true;                       // If player is on ground
-int gravity = 0;                            // Gravity power
+float gravity = 3600;                       // Gravity in pixels per second squared
+float fallSpeed = 0;                        // Player fall speed in pixels per second
+
+bool jumpQueued = false;                    // If jump was pressed since the last step
+bool shotQueued = false;                    // If shoot was pressed since the last step
 
 int life = 100;                             // Player life
 
-std::vector<Bullet *> bullets;              // Player bullets
-
-std::vector<Platform *> platforms = {       // Game platforms
-    new Platform({300, 200}, {100, 10}),
-    new Platform({880, 270}, {80, 10}),
-    new Platform({600, 350}, {110, 10}),
-    new Platform({400, 470}, {60, 10})
-};
+int maxBullets = 4096;                      // Bullets on screen at once. Shots are dropped past it
+EntityStore bullets(maxBullets);            // Player bullets
+int bulletsPerShot = 1;                     // Bullets fired each time the player shoots
+Vector2f bulletHSize = {3, 2};              // Bullet half size
+float bulletSpeed = 600;                    // Bullet speed in pixels per second
 
+EntityStore platforms(4);                   // Game platforms
+SpatialHash platformGrid(128);              // Platforms' boxes, hashed once by Init
 int currentPlat;                            // Player's current platform
 
-std::vector<Equation *> equations;          // Game enemies
-const char *equPaths[4] = {
-    "res\\equ1.png",
-    "res\\equ2.png",
-    "res\\equ3.png",
-    "res\\equ4.png"
+EntityStore equations(0);                   // Game enemies. Sized by Init
+int equationLife = 5;                       // Hits taken by an equation before it restarts
+float equationSpeed = 60;                   // Equation speed in pixels per second
+float equationScale = .15f;                 // Scale of the equations' images
+float equationHitScale = 1.5f;              // Scale of the equations' hit boxes over their images
+SpatialHash equationGrid(128);              // Equations' hit boxes, hashed each frame
+std::vector<int> hitCandidates;             // Equations or platforms near the bullet being tested
+TexturePack pack;                           // Pre-decoded images. Built by tools/texpack.cpp
+TextureAtlas atlas;                         // Pages the decoded images are packed in. Outlives the cache
+AssetCache assets;                          // Images shared by the equations
+std::vector<const char *> equPaths = {
+    "res/equ1.png",
+    "res/equ2.png",
+    "res/equ3.png",
+    "res/equ4.png"
 };
+std::vector<ImageHandle> equImages;         // Images of the equations. Released before the cache
 
 //==============================================================================
 // Game functions
 
-void Game::Init(Renderer *r)
+void Game::Init(Renderer *r, int equationCount, int shotBullets)
 {
-    for (int i = 0; i < 4; i++)
+    bulletsPerShot = shotBullets;
+    screenWidth = (float)r->GetBufferWidth();
+    if (pack.Open("res/textures.pack"))
+        assets.SetPack(&pack);
+    assets.SetAtlas(&atlas);
+    equImages = assets.LoadAll(equPaths, true, r->GetThreadPool());
+    equations.SetCapacity(equationCount);
+    for (int i = 0; i < equationCount; i++)
     {
-        Equation *equ = new Equation({r->GetBufferWidth()+150*i, 
-            (rand() % 3)*200 + 100}, 5, equPaths[i]);
-        r->objectsToDraw.push_back(equ->GetSprite());
-        equations.push_back(equ); 
+        Vector2i equPos = {r->GetBufferWidth()+150*i, (rand() % 3)*200 + 100};
+        Sprite *sprite = new Sprite(equPos, equationScale, equImages[i%equImages.size()].Get());
+        Vector2i size = sprite->GetImageSize()*equationScale;
+        r->AddObject(sprite);
+        equations.Add({(float)equPos.x, (float)equPos.y}, {(float)size.x, (float)size.y}, 
+            {-equationSpeed, 0}, equationLife, sprite);
     }
+
+    platforms.Clear();
+    platforms.Add({300, 200}, {100, 10}, {0, 0});
+    platforms.Add({880, 270}, {80, 10}, {0, 0});
+    platforms.Add({600, 350}, {110, 10}, {0, 0});
+    platforms.Add({400, 470}, {60, 10}, {0, 0});
+    platformGrid.Clear();
+    for (int i = 0; i < platforms.GetCount(); i++)
+        platformGrid.Insert(i, platforms.positions[i], platforms.halfSizes[i]);
+}
+
+/* Returns true if two boxes given by their center and half size overlap */
+static bool Overlap(Vector2f aPos, Vector2f aHSize, Vector2f bPos, Vector2f bHSize)
+{
+    return (aPos.y-aHSize.y <= bPos.y+bHSize.y) && (aPos.y+aHSize.y >= bPos.y-bHSize.y) &&
+        (aPos.x+aHSize.x >= bPos.x-bHSize.x) && (aPos.x-aHSize.x <= bPos.x+bHSize.x);
+}
+
+/**
+ * Returns true if a box moving by move touches a static box during the move
+ * Sets time to the fraction of the move done when they first touch, 0 if they already overlap
+ */
+static bool Sweep(Vector2f aPos, Vector2f aHSize, Vector2f move, Vector2f bPos, Vector2f bHSize, float &time)
+{
+    // The moving box is shrunk to it's center and the static box grown by it's half size
+    float start[2] = {aPos.x, aPos.y};
+    float delta[2] = {move.x, move.y};
+    float center[2] = {bPos.x, bPos.y};
+    float reach[2] = {aHSize.x+bHSize.x, aHSize.y+bHSize.y};
+
+    float enter = 0, exit = 1;
+    for (int axis = 0; axis < 2; axis++)
+    {
+        float low = center[axis]-reach[axis] - start[axis];
+        float high = center[axis]+reach[axis] - start[axis];
+        if (delta[axis] == 0)
+        {
+            if (low > 0 || high < 0)
+                return false;
+            continue;
+        }
+
+        float t0 = low/delta[axis];
+        float t1 = high/delta[axis];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        enter = max(enter, t0);
+        exit = min(exit, t1);
+        if (enter > exit)
+            return false;
+    }
+    time = enter;
+    return true;
+}
+
+/* Returns the half size of an equation's hit box */
+static Vector2f EquationHitSize(int index)
+{
+    return equations.halfSizes[index]*equationHitScale;
+}
+
+/* Sends an equation back to the right of the screen on a random row, with full life */
+static void RestartEquation(int index)
+{
+    equations.positions[index].x = screenWidth+(equations.halfSizes[index].x+10)*2;
+    equations.positions[index].y = (float)((rand() % 3)*200 + 100);
+    equations.hitPoints[index] = equationLife;
+    // The equation jumps to its new place instead of being interpolated across the screen
+    equations.previousPositions[index] = equations.positions[index];
 }
 
 void Game::Update(Renderer *r, Input *input, float dt)
 {
+    PROFILE_ZONE("Game::Update");
+
+    // Presses are kept until a step handles them, so none is lost or handled twice
+    jumpQueued = jumpQueued || input->Pressed(kButtonUp);
+    shotQueued = shotQueued || input->Pressed(kButtonSpace);
+
+    accumulator += min(dt, maxFrameTime);
+    while (accumulator >= stepTime)
+    {
+        Step(input, stepTime);
+        accumulator -= stepTime;
+    }
+    Draw(r, accumulator/stepTime);
+}
+
+void Game::Step(Input *input, float dt)
+{
+    previousPos = pos;
+    bullets.previousPositions = bullets.positions;
+    equations.previousPositions = equations.positions;
+
     //////////// Player Physics ///////////
 
     // Movement
-    int x = 0;
+    float x = 0;
     if (input->Down(kButtonLeft)) 
     {
-        x -= 5;
+        x -= speed;
         dir = -1;
     }
     if (input->Down(kButtonRight))
     {
-        x += 5;
+        x += speed;
         dir = 1;
     }
-    pos.x += x;
+    pos.x += x*dt;
 
     // Jump
-    if (input->Pressed(kButtonUp) && !jumped && onGround) 
+    if (jumpQueued && !jumped && onGround) 
     {
         jumped = true;
         onGround = false;
     }
+    jumpQueued = false;
     
     if (jumped)
     {
-        pos.y += jumpHeight;
+        pos.y += jumpSpeed*dt;
         if (onGround)
             jumped = false;
     }
 
     // Gravity
-    if (!onGround) gravity++;
+    if (!onGround) fallSpeed += gravity*dt;
 
-    if (pos.y-gravity <= 100)
+    if (pos.y-fallSpeed*dt <= 100)
     {
         onGround = true;
         jumped = false;
         pos.y = 100;
-        gravity = 0;
+        fallSpeed = 0;
     }
-    pos.y -= gravity;
+    pos.y -= fallSpeed*dt;
 
     // Platforms collisions
-    for (int i=0; i < (int)platforms.size(); i++)
+    for (int i=0; i < platforms.GetCount(); i++)
     {
-        Platform *p = platforms.at(i);
-
-        bool collision = p->Collide(pos, hSize);
+        bool collision = Overlap(pos, hSize, platforms.positions[i], platforms.halfSizes[i]);
         if (!collision && currentPlat == i && pos.y > 100)
         {
             onGround = false;
             currentPlat = -1;
         }
-        else if (collision && (!jumped || jumpHeight-gravity < 0) && currentPlat == -1)
+        else if (collision && (!jumped || jumpSpeed-fallSpeed < 0) && currentPlat == -1)
         {
-            pos.y = p->Ground()+hSize.y;
+            pos.y = platforms.positions[i].y+platforms.halfSizes[i].y+hSize.y;
             onGround = true;
             jumped = false;
-            gravity = 0;
+            fallSpeed = 0;
             currentPlat = i;
         }
     }
-    /////////// Game Management ///////////
-
-    // Life bar
-    r->DrawRect({220, r->GetBufferHeight()-20}, {200, 10}, 0x282C34);
-    r->DrawRect({20+life*2, r->GetBufferHeight()-20}, {life*2, 10}, 0xE6C440);
 
     ///////////// Game Assets /////////////
 
     // Bullets
-    if (input->Pressed(kButtonSpace))
-        bullets.push_back(new Bullet(pos, dir));
+    if (shotQueued)
+    {
+        // Extra bullets are stacked above and below the player's
+        for (int i = 0; i < bulletsPerShot; i++)
+        {
+            Vector2f bulletPos = {pos.x, pos.y + (i%2 ? 1 : -1)*((i+1)/2)*6};
+            bullets.Add(bulletPos, bulletHSize, {bulletSpeed*dir, 0});
+        }
+    }
+    shotQueued = false;
 
-    for (int i=0; i < (int)bullets.size(); i++)
+    // Bullets are only tested against the equations and platforms sharing a cell with them
+    equationGrid.Clear();
+    for (int e = 0; e < equations.GetCount(); e++)
+        equationGrid.Insert(e, equations.positions[e], EquationHitSize(e));
+
+    for (int i=0; i < bullets.GetCount(); i++)
     {
-        Bullet *b = bullets[i];
-        b->Update(r);
-        for (Equation *equ : equations)
+        // Bullets sweep their box along their move, so they can't go through anything whatever their speed.
+        // Equations move slowly enough to be taken as static during the move
+        Vector2f &bulletPos = bullets.positions[i];
+        Vector2f halfSize = bullets.halfSizes[i];
+        Vector2f move = bullets.velocities[i]*dt;
+        Vector2f sweepPos = {bulletPos.x + move.x/2, bulletPos.y + move.y/2};
+        Vector2f sweepHSize = {halfSize.x + Abs(move.x)/2, halfSize.y + Abs(move.y)/2};
+
+        // The bullet stops on the first equation or platform it touches
+        float hitTime = 2, time;
+        int hitEquation = -1;
+        hitCandidates.clear();
+        equationGrid.Query(sweepPos, sweepHSize, hitCandidates);
+        for (int e : hitCandidates)
+        {
+            if (Sweep(bulletPos, halfSize, move, equations.positions[e], EquationHitSize(e), time) && time < hitTime)
+            {
+                hitTime = time;
+                hitEquation = e;
+            }
+        }
+        hitCandidates.clear();
+        platformGrid.Query(sweepPos, sweepHSize, hitCandidates);
+        for (int p : hitCandidates)
+        {
+            if (Sweep(bulletPos, halfSize, move, platforms.positions[p], platforms.halfSizes[p], time) && time < hitTime)
+            {
+                hitTime = time;
+                hitEquation = -1;
+            }
+        }
+
+        if (hitTime <= 1)
         {
-            if (b->Hit(equ->GetPos(), equ->GetSize()*1.5f))
+            if (hitEquation >= 0 && --equations.hitPoints[hitEquation] <= 0)
             {
-                equ->GetHit();
-                bullets.erase(bullets.begin()+i);
-                i--;
-                continue;
+                RestartEquation(hitEquation);
+                equationGrid.Insert(hitEquation, equations.positions[hitEquation], EquationHitSize(hitEquation));
             }
+            bullets.Remove(i);
+            i--;
+            continue;
+        }
+
+        bulletPos += move;
+        if (bulletPos.x+halfSize.x >= screenWidth || bulletPos.x-halfSize.x < 0)
+        {
+            bullets.Remove(i);
+            i--;
         }
-        b->Draw(r);
-        if (b->NotOnScreen())
-            bullets.erase(bullets.begin()+i);
     }
     
     // Equations
-    for (Equation *equ : equations)
+    for (int e = 0; e < equations.GetCount(); e++)
     {
-        equ->Update();
-        if (equ->OutOfBound())
+        Vector2f move = equations.velocities[e]*dt;
+        equations.positions[e] += move;
+        if (equations.positions[e].x + equations.halfSizes[e].x/2 < 0)
         {
-            equ->Restart();
+            RestartEquation(e);
             life -= 10;
         }
     }
+}
 
-    r->DrawRect({600, 40}, {600, 40}, 0x4049E6);
-    r->DrawRect(pos, hSize, 0xE6C440);
+void Game::Draw(Renderer *r, float alpha)
+{
+    // Moving things are drawn between their last two steps
+    for (int e = 0; e < equations.GetCount(); e++)
+        equations.sprites[e]->SetPosition(ToVector2i(Lerp(equations.previousPositions[e], equations.positions[e], alpha)));
 
-    for (int i=0; i < (int)platforms.size(); i++)
+    // Life bar
+    r->DrawRect({220, r->GetBufferHeight()-20}, {200, 10}, 0x282C34);
+    r->DrawRect({20+life*2, r->GetBufferHeight()-20}, {life*2, 10}, 0xE6C440);
+
+    for (int i=0; i < bullets.GetCount(); i++)
     {
-        Platform *p = platforms.at(i);
-        p->Draw(r);
+        Vector2f bulletPos = Lerp(bullets.previousPositions[i], bullets.positions[i], alpha);
+        r->DrawRect(ToVector2i(bulletPos), ToVector2i(bullets.halfSizes[i]), 0xE6C440);
     }
+
+    r->DrawRect({600, 40}, {600, 40}, 0x4049E6);
+    r->DrawRect(ToVector2i(Lerp(previousPos, pos, alpha)), ToVector2i(hSize), 0xE6C440);
+
+    for (int i=0; i < platforms.GetCount(); i++)
+        r->DrawRect(ToVector2i(platforms.positions[i]), ToVector2i(platforms.halfSizes[i]), 0x6169FF);
+}
+
+const AssetCache &Game::GetAssets() const
+{
+    return assets;
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+/**
+ * @file headless.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the HeadlessWindow class's implementation
+ */
+
+#include "Headless.hpp"
+#include "FileWriter.hpp"
+#include "Profiler.hpp"
+#include <stdio.h>
+
+HeadlessWindow::HeadlessWindow(int width, int height, float ft)
+    : _pixels((size_t)width*height), _ft(ft)
+{
+    _buffer = {};
+    _buffer.width = width;
+    _buffer.height = height;
+    _buffer.pixels = _pixels.data();
+}
+
+HeadlessWindow::~HeadlessWindow()
+{
+}
+
+void HeadlessWindow::HandleMessages()
+{
+}
+
+void HeadlessWindow::ProcessFrame()
+{
+    PROFILE_ZONE("HeadlessWindow::ProcessFrame");
+    // A render thread hasn't completed any buffer on the first frame
+    if (!_dumpFolder.empty() && _frame % _dumpEvery == 0 && (_presented || !_pipelined))
+        DumpFrame();
+
+    if (_paced)
+        _lastFt = _pacer.Wait();
+
+    _frame++;
+    if (_frameLimit > 0 && _frame >= _frameLimit)
+        _running = false;
+}
+
+void HeadlessWindow::ProcessFrame(const std::vector<ScreenRect> &)
+{
+    ProcessFrame();
+}
+
+void HeadlessWindow::ProcessFrame(const WinBuffer *buffer)
+{
+    _pipelined = true;
+    if (buffer)
+        _presented = buffer;
+    ProcessFrame();
+}
+
+void HeadlessWindow::StopPresenting()
+{
+    _presented = nullptr;
+    _pipelined = false;
+}
+
+void HeadlessWindow::DumpFrame()
+{
+    char path[512];
+    bool png = _dumpFormat == kDumpPng;
+    const WinBuffer &buffer = (_presented) ? *_presented : _buffer;
+    snprintf(path, sizeof(path), "%s/frame_%05d.%s", _dumpFolder.c_str(), _frame, png ? "png" : "raw");
+
+    bool written = png
+        ? WritePng(path, buffer.pixels, buffer.width, buffer.height, true)
+        : WriteRaw(path, buffer.pixels, buffer.width, buffer.height);
+    if (!written)
+    {
+        fprintf(stderr, "Could not write %s, frame dumps are disabled\n", path);
+        _dumpFolder.clear();
+    }
+}
+
+void HeadlessWindow::SetBackgroundColor(unsigned int) const
+{
+}
+
+void HeadlessWindow::SetFrameLimit(int frameCount)
+{
+    _frameLimit = frameCount;
+}
+
+void HeadlessWindow::SetFrameDump(const char *folder, int every, DumpFormat format)
+{
+    _dumpFolder = folder ? folder : "";
+    _dumpEvery = (every > 0) ? every : 1;
+    _dumpFormat = format;
+}
+
+void HeadlessWindow::EnablePacing(float fps)
+{
+    _paced = true;
+    _pacer.SetTarget(fps);
+    _pacer.ResetStats();
+    _lastFt = (fps > 0) ? 1.f/fps : _ft;
+}
+
+void HeadlessWindow::Close()
+{
+    _running = false;
+}
+
+bool HeadlessWindow::IsRunning() const
+{
+    return _running;
+}
+
+WinBuffer *HeadlessWindow::GetBuffer()
+{
+    return &_buffer;
+}
+
+float HeadlessWindow::GetFt() const
+{
+    return (_paced) ? _lastFt : _ft;
+}
+
+int HeadlessWindow::GetFrameCount() const
+{
+    return _frame;
+}
+
+FramePacer &HeadlessWindow::GetPacer()
+{
+    return _pacer;
+}
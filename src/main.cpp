@@ -2,28 +2,67 @@
  * @file main.cpp
  * @author Julie Fiadino
  * @copyright Copyright 2021 (C) Julie Fiadino
- * 
+ *
  * This file defines the overall program system
  */
 
-#include <Windows.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include "Window.hpp"
+#include "Headless.hpp"
 #include "Math.hpp"
 #include "Renderer.hpp"
 #include "Game.hpp"
+#include "Profiler.hpp"
+#include "RenderThread.hpp"
+#include <limits.h>
+#include <memory>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 //==============================================================================
-// WinApi main loop
+// Command line
 
-int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nShowCmd)
+/* Reads a number spanning the whole text. Returns false if text isn't one */
+static bool ParseNumber(const char *text, double &value)
+{
+    char *end;
+    value = strtod(text, &end);
+    return end != text && *end == 0;
+}
+
+/* Returns true if a render thread can be given that number of buffers. 0 doesn't use one */
+static bool IsBufferCount(double value)
+{
+    return value == 0 || value == 2 || value == 3;
+}
+
+//==============================================================================
+// Main loop
+
+/**
+ * Runs the game until the window is closed. Works with a Window or a HeadlessWindow
+ * With 2 or 3 buffers, frames are rasterized on a render thread while the next one is recorded
+ * and presented from the last completed buffer. 0 rasterizes and presents each frame in turn
+ * If frames aren't paced to real time, no frame is dropped: each one waits for the previous one
+ * to be rasterized
+ */
+template <typename W>
+static void RunGame(W &win, int buffers, bool paced)
 {
-    Window win("Math Shooter", 1200, 720, hInstance);
     win.SetBackgroundColor(0x242C66);
-    Renderer renderer(win);
+    Renderer renderer(win.GetBuffer());
+    renderer.EnableBinning((int)std::thread::hardware_concurrency());
+    renderer.EnableDamageTracking(true);
     Game game;
     game.Init(&renderer);
 
+    // Declared after the game: the render thread stops before the images it draws are freed
+    std::unique_ptr<RenderThread> renderThread;
+    if (buffers > 0)
+        renderThread.reset(new RenderThread(&renderer, buffers, paced));
+
     while (win.IsRunning())
     {
         renderer.ClearScreen(0x242C66);
@@ -32,9 +71,160 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
         renderer.Update(win.GetFt());
 
         game.Update(&renderer, &win.input, win.GetFt());
+        renderer.EndFrame();
+
+        if (renderThread)
+        {
+            renderThread->Submit();
+            win.ProcessFrame(renderThread->TakeCompletedBuffer());
+        }
+        else
+            win.ProcessFrame(renderer.GetDirtyRects());
+    }
 
-        win.ProcessFrame();
+    if (renderThread)
+    {
+        win.StopPresenting();
+        renderThread->Report(stdout);
     }
+}
+
+#ifdef _WIN32
+//==============================================================================
+// WinApi main loop
+
+/* Reports a command line argument that isn't understood. WinMain has no console, so it goes to the debugger */
+static void IgnoreArgument(const char *arg)
+{
+    char message[256];
+    snprintf(message, sizeof(message), "Ignored command line argument: %s\n", arg);
+    OutputDebugStringA(message);
+}
+
+int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nShowCmd)
+{
+    // The command line can set the target framerate, 0 leaves it uncapped,
+    // and --pipeline followed by 2 or 3 buffers renders on a render thread
+    Window win("Math Shooter", 1200, 720, hInstance);
+    int buffers = 0;
+    double value;
+    for (char *arg = strtok(lpCmdLine, " "); arg; arg = strtok(0, " "))
+    {
+        if (!strcmp(arg, "--pipeline"))
+        {
+            arg = strtok(0, " ");
+            if (arg && ParseNumber(arg, value) && IsBufferCount(value))
+                buffers = (int)value;
+            else if (arg)
+                IgnoreArgument(arg);
+        }
+        else if (ParseNumber(arg, value))
+            win.GetPacer().SetTarget((float)value);
+        else
+            IgnoreArgument(arg);
+    }
+    RunGame(win, buffers, true);
+#ifdef PROFILER_ENABLED
+    ExportChromeTrace("trace.json");
+#endif
+
+    return 0;
+}
+#else
+//==============================================================================
+// Headless main loop
+
+/**
+ * Reads the value of an option, a number of at least minimum, and a whole one if integer is true
+ * Reports it on stderr and returns false if it isn't
+ */
+static bool ParseOption(const char *option, const char *text, double minimum, bool integer, double &value)
+{
+    if (ParseNumber(text, value) && value >= minimum && (!integer || (value <= INT_MAX && value == (int)value)))
+        return true;
+    fprintf(stderr, "Ignored %s %s: expected %s of at least %g\n", option, text,
+        (integer) ? "a whole number" : "a number", minimum);
+    return false;
+}
+
+/**
+ * Runs the game offscreen at 60 frames per second of game time
+ * Usage: Math_Shooter [--frames count] [--dump folder] [--every n] [--raw] [--trace file] [--pace fps]
+ *     [--pipeline buffers]
+ * Runs 600 frames by default, 0 runs until killed
+ * When paced, frames run in real time and pacing statistics are printed on exit
+ * When pipelined, frames are rasterized on a render thread into 2 or 3 buffers, and its
+ * statistics are printed on exit. Dumped frames are then one frame behind the game
+ * The trace is only written when built with PROFILER_ENABLED
+ */
+int main(int argc, char **argv)
+{
+    int frames = 600;
+    const char *dumpFolder = 0;
+    int every = 1;
+    DumpFormat format = kDumpPng;
+    const char *traceFile = 0;
+    float pace = -1;
+    int buffers = 0;
+
+    double value;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        bool hasValue = i+1 < argc;
+        if (!strcmp(option, "--raw"))
+            format = kDumpRaw;
+        else if (!strcmp(option, "--dump") && hasValue)
+            dumpFolder = argv[++i];
+        else if (!strcmp(option, "--trace") && hasValue)
+            traceFile = argv[++i];
+        else if (!strcmp(option, "--frames") && hasValue)
+        {
+            if (ParseOption(option, argv[++i], 0, true, value))
+                frames = (int)value;
+        }
+        else if (!strcmp(option, "--every") && hasValue)
+        {
+            if (ParseOption(option, argv[++i], 1, true, value))
+                every = (int)value;
+        }
+        else if (!strcmp(option, "--pace") && hasValue)
+        {
+            if (ParseOption(option, argv[++i], 0, false, value))
+                pace = (float)value;
+        }
+        else if (!strcmp(option, "--pipeline") && hasValue)
+        {
+            if (!ParseOption(option, argv[++i], 0, true, value))
+                continue;
+            if (IsBufferCount(value))
+                buffers = (int)value;
+            else
+                fprintf(stderr, "Ignored --pipeline %s: the render thread takes 2 or 3 buffers, 0 doesn't use it\n", argv[i]);
+        }
+        else
+            fprintf(stderr, "Ignored command line argument: %s\n", option);
+    }
+
+    HeadlessWindow win(1200, 720);
+    win.SetFrameLimit(frames);
+    if (dumpFolder)
+        win.SetFrameDump(dumpFolder, every, format);
+    if (pace >= 0)
+        win.EnablePacing(pace);
+    RunGame(win, buffers, pace >= 0);
+
+    if (pace >= 0)
+        win.GetPacer().Report(stdout);
+
+#ifdef PROFILER_ENABLED
+    if (traceFile && !ExportChromeTrace(traceFile))
+        fprintf(stderr, "Could not write %s\n", traceFile);
+#else
+    if (traceFile)
+        fprintf(stderr, "Built without PROFILER_ENABLED, %s is not written\n", traceFile);
+#endif
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file profiler.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the zone profiler's implementation
+ */
+
+#include "Profiler.hpp"
+#include "FileWriter.hpp"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+static const unsigned int kZoneCapacity = 1 << 16;     // zones kept per thread. Must be a power of 2
+
+// A timed zone
+struct ProfileEvent
+{
+    const char *name;       // zone name
+    long long start, end;   // enter and exit times in ns
+};
+
+// The zones recorded by a thread
+struct ProfileBuffer
+{
+    std::vector<ProfileEvent> events;   // ring buffer of zones
+    std::atomic<unsigned int> written;  // number of zones ever recorded. Only written by its thread
+    int thread;                         // index of the thread, in order of first zone
+};
+
+static std::mutex buffersMutex;                 // protects the buffer list. Only locked once per thread
+static std::vector<ProfileBuffer *> buffers;    // buffer of each thread. Kept after threads exit
+
+/* Returns the calling thread's buffer, creating it on first use */
+static ProfileBuffer *ThreadBuffer()
+{
+    thread_local ProfileBuffer *buffer = nullptr;
+    if (!buffer)
+    {
+        buffer = new ProfileBuffer;
+        buffer->events.resize(kZoneCapacity);
+        buffer->written = 0;
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffer->thread = (int)buffers.size();
+        buffers.push_back(buffer);
+    }
+    return buffer;
+}
+
+void RecordZone(const char *name, long long start, long long end)
+{
+    ProfileBuffer *buffer = ThreadBuffer();
+    unsigned int index = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[index & (kZoneCapacity-1)] = {name, start, end};
+    buffer->written.store(index+1, std::memory_order_release);
+}
+
+bool ExportChromeTrace(const char *filePath)
+{
+    FILE *file = OpenFileForWriting(filePath);
+    if (!file)
+        return false;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    // Timestamps start at the oldest zone still recorded
+    long long origin = -1;
+    for (ProfileBuffer *buffer : buffers)
+    {
+        unsigned int written = buffer->written.load(std::memory_order_acquire);
+        unsigned int first = (written > kZoneCapacity) ? written-kZoneCapacity : 0;
+        for (unsigned int i = first; i < written; i++)
+        {
+            long long start = buffer->events[i & (kZoneCapacity-1)].start;
+            if (origin < 0 || start < origin) origin = start;
+        }
+    }
+
+    fprintf(file, "{\"traceEvents\":[");
+    bool firstEvent = true;
+    for (ProfileBuffer *buffer : buffers)
+    {
+        unsigned int written = buffer->written.load(std::memory_order_acquire);
+        unsigned int first = (written > kZoneCapacity) ? written-kZoneCapacity : 0;
+        for (unsigned int i = first; i < written; i++)
+        {
+            const ProfileEvent &e = buffer->events[i & (kZoneCapacity-1)];
+            fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d}",
+                firstEvent ? "" : ",", e.name, (e.start-origin)/1000.0, (e.end-e.start)/1000.0, buffer->thread);
+            firstEvent = false;
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    bool written = !ferror(file);
+    fclose(file);
+    return written;
+}
+
+void ClearZones()
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (ProfileBuffer *buffer : buffers)
+        buffer->written = 0;
+}
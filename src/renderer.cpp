@@ -10,136 +10,360 @@
 #include "Math.hpp"
 #include "Sprite.hpp"
 #include "Text.hpp"
+#include "PixelOps.hpp"
+#include "ThreadPool.hpp"
+#include "Profiler.hpp"
 #include <algorithm>
+#include <chrono>
+#include <string.h>
 
-Renderer::Renderer(Window win)
+static const int kTileWidth = 128;         // width of a binning tile
+static const int kTileHeight = 64;          // height of a binning tile
+static const int kStreamFillPixels = 4 << 20; // smallest clear made with non-temporal stores, see fill_bench
+static const int kMaxSortedDraws = 1 << 20;   // draws per list a sort key can index. Later ones aren't drawn
+static const unsigned int kMaterialMask = 0x1ff; // material bits of a sort key. Materials past 512 share groups
+
+/* Returns the time elapsed since start in ms */
+static float ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+Renderer::Renderer(WinBuffer *buffer)
 {
-    _buffer = win.GetBuffer();
+    _buffer = buffer;
+    _target = buffer;
+    _scanlines.resize(1);
 }
 
 Renderer::~Renderer()
 {
+    delete _pool;
 }
 
 void Renderer::ClearScreen(unsigned int color)
 {
-    unsigned int *pixel = _buffer->pixels;
-    for (int y = 0; y < _buffer->height; y++)
+    auto start = std::chrono::steady_clock::now();
+    bool resized = _buffer->pixels != _lastBuffer.pixels || 
+        _buffer->width != _lastBuffer.width || _buffer->height != _lastBuffer.height;
+    if (!_trackDamage || _pipelined || resized || color != _clearColor)
+        _fullRedraw = true;
+    _clearColor = color;
+    _lastBuffer = *_buffer;
+
+    DrawCommand command = {kCommandClear};
+    command.color = color;
+    if (_fullRedraw)
+    {
+        command.rect = {0, 0, _buffer->width, _buffer->height};
+        Submit(command);
+    }
+    else
     {
-        for (int x = 0; x < _buffer->width; x++)
+        // The rest of the buffer still holds the clear color
+        for (const ScreenRect &r : _lastDamage)
         {
-            *pixel++ = color;
+            command.rect = r;
+            Submit(command);
         }
     }
+    _stats.clear += ElapsedMs(start);
 }
 
 void Renderer::DrawRect(Vector2i pos, Vector2i hSize, unsigned int color)
 {
-    int xmin = max(0, pos.x-hSize.x);
-    int xmax = min(_buffer->width, pos.x+hSize.x);
-    int ymin = max(0, pos.y-hSize.y);
-    int ymax = min(_buffer->height, pos.y+hSize.y);
+    DrawCommand command = {kCommandRect};
+    command.rect = {pos.x-hSize.x, pos.y-hSize.y, pos.x+hSize.x, pos.y+hSize.y};
+    command.color = color;
+    Submit(command);
+}
+
+void Renderer::DrawRoundedRect(Vector2i pos, Vector2i hSize, int radius, unsigned int color, bool antialiased)
+{
+    DrawCommand command = {kCommandRoundedRect};
+    command.rect = {pos.x-hSize.x, pos.y-hSize.y, pos.x+hSize.x, pos.y+hSize.y};
+    command.color = color;
+    command.radius = radius;
+    command.antialiased = antialiased;
+    Submit(command);
+}
+
+void Renderer::BlitScaled(const Bitmap &img, int srcX, int srcY, int srcW, int srcH, 
+    int x0, int y0, int x1, int y1, bool reversed)
+{
+    if (x1 <= x0 || y1 <= y0 || srcW <= 0 || srcH <= 0) return;
+
+    DrawCommand command = {kCommandBlit};
+    command.rect = {x0, y0, x1, y1};
+    command.img = img;
+    command.src = {srcX, srcY, srcX+srcW, srcY+srcH};
+    command.reversed = reversed;
+    Submit(command);
+}
+
+//==============================================================================
+// Rasterization
+
+void Renderer::Submit(const DrawCommand &command)
+{
+    _stats.commands++;
+    if (_trackDamage && command.type != kCommandClear)
+    {
+        ScreenRect r = {
+            max(0, command.rect.x0), max(0, command.rect.y0), 
+            min(_buffer->width, command.rect.x1), min(_buffer->height, command.rect.y1)
+        };
+        if (r.x0 < r.x1 && r.y0 < r.y1)
+            _damage.push_back(r);
+    }
 
-    for (int y = ymin; y < ymax; y++)
+    if (_binning)
     {
-        unsigned int *pixel = _buffer->pixels + y*_buffer->width + xmin;
-        for (int x = xmin; x < xmax; x++)
-        {
-            *pixel++ = color;
-        }
+        _commands.push_back(command);
+        return;
     }
+
+    std::vector<unsigned int> &scanline = _scanlines[0];
+    if ((int)scanline.size() < _buffer->width) scanline.resize(_buffer->width);
+    _target = _buffer;
+    Raster(command, {0, 0, _buffer->width, _buffer->height}, scanline.data());
 }
 
-void Renderer::DrawRoundedRect(Vector2i pos, Vector2i hSize, int radius, unsigned int color)
+void Renderer::Raster(const DrawCommand &command, ScreenRect clip, unsigned int *scanline)
 {
-    int xmin = max(0, pos.x-hSize.x);
-    int xmax = min(_buffer->width, pos.x+hSize.x);
-    int ymin = max(0, pos.y-hSize.y);
-    int ymax = min(_buffer->height, pos.y+hSize.y);
+    switch (command.type)
+    {
+        case kCommandClear:
+        case kCommandRect: RasterFill(command, clip); break;
+        case kCommandRoundedRect: RasterRoundedRect(command, clip); break;
+        case kCommandBlit: RasterBlit(command, clip, scanline); break;
+    }
+}
+
+void Renderer::RasterFill(const DrawCommand &command, ScreenRect clip)
+{
+    int xmin = max(clip.x0, command.rect.x0);
+    int xmax = min(clip.x1, command.rect.x1);
+    int ymin = max(clip.y0, command.rect.y0);
+    int ymax = min(clip.y1, command.rect.y1);
+    if (xmin >= xmax) return;
+
+    // Streaming stores skip the cache, so they only pay off when the filled region is too big
+    // to stay cached until the next draws: immediate full buffer clears of large buffers.
+    // Binned tiles are small and blended into right after their clear
+    bool stream = command.type == kCommandClear && 
+        xmin == 0 && ymin == 0 && xmax == _target->width && ymax == _target->height &&
+        (long long)_target->width*_target->height >= kStreamFillPixels;
+    FillRowFunc fill = (stream) ? FillRowStream : FillRow;
 
-    for (int y = ymin; y < ymax; y++)
+    unsigned int *pixel = _target->pixels + ymin*_target->width + xmin;
+    for (int y = ymin; y < ymax; y++, pixel += _target->width)
+        fill(pixel, command.color, xmax-xmin);
+
+    if (stream)
+        FillFence();
+}
+
+/* Returns the biggest integer whose square is at most n */
+static int ISqrt(int n)
+{
+    if (n <= 0) return 0;
+    int s = (int)sqrtf((float)n);
+    while (s*s > n) s--;
+    while ((s+1)*(s+1) <= n) s++;
+    return s;
+}
+
+/* Fills the pixels [x0,x1[ of a row, clipped to [xmin,xmax[ */
+static void FillSpan(unsigned int *row, int x0, int x1, int xmin, int xmax, unsigned int color)
+{
+    x0 = max(x0, xmin);
+    x1 = min(x1, xmax);
+    if (x0 < x1)
+        FillRow(row+x0, color, x1-x0);
+}
+
+/* Blends color over the pixels [x0,x1[ of a row, clipped to [xmin,xmax[, with a coverage in [0,1] */
+static void BlendSpan(unsigned int *row, int x0, int x1, int xmin, int xmax, unsigned int color, float coverage)
+{
+    if (coverage <= 0.f) return;
+    if (coverage >= 1.f)
     {
-        unsigned int *pixel = _buffer->pixels + y*_buffer->width + xmin;
-        for (int x = xmin; x < xmax; x++)
+        FillSpan(row, x0, x1, xmin, xmax, color);
+        return;
+    }
+
+    unsigned int src = (color & 0xffffff) | ((unsigned int)(coverage*255.f + .5f) << 24);
+    for (int x = max(x0, xmin); x < min(x1, xmax); x++)
+        row[x] = BlendPixel(row[x], src);
+}
+
+void Renderer::RasterRoundedRect(const DrawCommand &command, ScreenRect clip)
+{
+    // Corners are placed on the rect clamped to the buffer, whatever the clip is
+    int xmin = max(0, command.rect.x0);
+    int xmax = min(_target->width, command.rect.x1);
+    int ymin = max(0, command.rect.y0);
+    int ymax = min(_target->height, command.rect.y1);
+    if (xmin >= xmax || ymin >= ymax) return;
+    int radius = Clamp(0, command.radius, min(xmax-xmin, ymax-ymin)/2);
+    unsigned int color = command.color;
+
+    // Corner centers
+    int cxLeft = xmin+radius;
+    int cxRight = xmax-radius-1;
+    int cyBottom = ymin+radius;
+    int cyTop = ymax-radius-1;
+
+    int x0 = max(xmin, clip.x0);
+    int x1 = min(xmax, clip.x1);
+    for (int y = max(ymin, clip.y0); y < min(ymax, clip.y1); y++)
+    {
+        unsigned int *row = _target->pixels + y*_target->width;
+        int dy = (y < cyBottom) ? cyBottom-y : ((y > cyTop) ? y-cyTop : 0);
+
+        if (dy == 0)
         {
-            if ((y < ymin+radius || y >= ymax-radius-1) && (x < xmin+radius || x >= xmax-radius-1))
-            {
-                int w = xmax-xmin;
-                int h = ymax-ymin;
-                int mx = (xmin+xmax)/2;
-                int my = (ymin+ymax)/2;
-
-                Vector2i corner = {
-                    w*(x > mx) + radius*((x < mx)*2 - 1) - 1*(x > mx), 
-                    h*(y > my) + radius*((y < my)*2 - 1) - 1*(y > my)
-                };
-
-                if (Distance(corner, {x-xmin, y-ymin}) > radius)
-                {
-                    pixel++;
-                    continue;
-                }
-            }
-            *pixel++ = color;
+            FillSpan(row, x0, x1, x0, x1, color);
+            continue;
         }
-    }   
+
+        // Each row of the corners is covered from the left circle to the right one
+        int dx = ISqrt(radius*radius - dy*dy);
+        FillSpan(row, cxLeft-dx, cxRight+dx+1, x0, x1, color);
+        if (!command.antialiased) continue;
+
+        // The true edge is half a pixel past the last covered center, so the pixels
+        // less than a pixel further out are blended by how far they are inside it
+        int edge = min(radius, (int)sqrtf(Square(radius+1.f) - (float)(dy*dy)));
+        for (dx++; dx <= edge; dx++)
+        {
+            float coverage = radius+1.f - sqrtf((float)(dx*dx + dy*dy));
+            BlendSpan(row, cxLeft-dx, cxLeft-dx+1, x0, x1, color, coverage);
+            BlendSpan(row, cxRight+dx, cxRight+dx+1, x0, x1, color, coverage);
+        }
+    }
 }
 
-void Renderer::DrawLetter(Font *font, int index, Vector2i pos, Vector2i hSize)
+/**
+ * Samples count texels into out. src is the first texel of the sub-rect row, or the last one when reversed
+ * Texels are anded with mask, which clears the alpha byte of copied texels
+ */
+static void SampleRow(unsigned int *out, const unsigned int *src, int fx, int stepX, int count, bool reversed, 
+    unsigned int mask)
+{
+    if (!reversed)
+    {
+        for (int i = 0; i < count; i++, fx += stepX)
+            *out++ = src[fx >> 16] & mask;
+    }
+    else 
+    {
+        for (int i = 0; i < count; i++, fx += stepX)
+            *out++ = src[-(fx >> 16)] & mask;
+    }
+}
+
+/* Returns the index of the first screen pixel sampling texel k or further. Clamped to [0,count] */
+static int FirstSampleAt(int k, int fx0, int stepX, int count)
 {
-    int x0 = (int)(pos.x-hSize.x)-_cam.x;
-    int y0 = (int)(pos.y-hSize.y)-_cam.y;
-    int x1 = (int)(pos.x+hSize.x)-_cam.x;
-    int y1 = (int)(pos.y+hSize.y)-_cam.y;
-
-    float xRange = (float)(x1 - x0);
-    float yRange = (float)(y1 - y0);
-    
-    x0 = Clamp(0, x0, _buffer->width);
-    x1 = Clamp(0, x1, _buffer->width);
-    y0 = Clamp(0, y0, _buffer->height);
-    y1 = Clamp(0, y1, _buffer->height);
-    
-    unsigned int *row = _buffer->pixels + x0 + _buffer->width*y0;
-    unsigned int *pixel = row;
-    int stride = _buffer->width;
-    for (int y = y0; y < y1; y++) 
+    long long d = ((long long)k << 16) - fx0;
+    if (d <= 0) return 0;
+    long long i = (d + stepX - 1)/stepX;
+    return (i < count) ? (int)i : count;
+}
+
+void Renderer::RasterBlit(const DrawCommand &command, ScreenRect clip, unsigned int *scanline)
+{
+    const Bitmap &img = command.img;
+    int x0 = command.rect.x0, y0 = command.rect.y0;
+    int x1 = command.rect.x1, y1 = command.rect.y1;
+    int srcX = command.src.x0, srcY = command.src.y0;
+    int srcW = command.src.x1-srcX, srcH = command.src.y1-srcY;
+    bool reversed = command.reversed;
+
+    int x0Clamped = Clamp(clip.x0, x0, clip.x1);
+    int y0Clamped = Clamp(clip.y0, y0, clip.y1);
+    int x1Clamped = Clamp(clip.x0, x1, clip.x1);
+    int y1Clamped = Clamp(clip.y0, y1, clip.y1);
+    int count = x1Clamped-x0Clamped;
+    if (count <= 0 || y1Clamped <= y0Clamped) return;
+
+    // 16.16 fixed-point source steps for one screen pixel
+    int stepX = (int)(((long long)srcW << 16)/(x1-x0));
+    int stepY = (int)(((long long)srcH << 16)/(y1-y0));
+
+    // Source position of the first visible pixel
+    int fx0 = (x0Clamped-x0)*stepX;
+    int fy = (y0Clamped-y0)*stepY;
+    bool unscaled = !reversed && stepX == (1 << 16);
+    BlendRowFunc blend = (img.premultiplied) ? BlendRowPremultiplied : BlendRow;
+
+    unsigned int *row = _target->pixels + x0Clamped + _target->width*y0Clamped;
+    int stride = _target->width;
+    for (int y = y0Clamped; y < y1Clamped; y++, row += stride) 
     {  
-        float v = ((float)y-y0)/yRange;
-        int uvStride = (int)(v*(float)font->lHeight)*font->bitmap.width;
-        unsigned int *src_pixels = font->bitmap.pixels + uvStride;
-        for (int x = x0; x < x1; x++) 
+        int sy = srcY + (fy >> 16);
+        fy += stepY;
+        const unsigned int *srcRow = img.pixels + sy*img.pitch;
+        const unsigned int *src = srcRow + ((reversed) ? srcX+srcW-1 : srcX);
+
+        // Without spans the whole row is one blend span
+        PixelSpan all = {srcX, srcX+srcW, kSpanBlend};
+        const PixelSpan *span = &all;
+        const PixelSpan *spanEnd = span+1;
+        if (img.spans)
         {
-            float u = ((float)x-x0)/xRange;
-            
-            int px = (int)(u*(float)font->lWidth)+index*font->lWidth;
-            
-            unsigned int bmpColor = *(src_pixels + px);
-            
-            float alpha = (float)((bmpColor & 0xff000000) >> 24)/255.f;
-            
-            float ar = (float)((*pixel & 0xff0000) >> 16);
-            float ag = (float)((*pixel & 0xff00) >> 8);
-            float ab = (float)(*pixel & 0xff);
-            
-            float br = (float)((bmpColor & 0xff0000) >> 16);
-            float bg = (float)((bmpColor & 0xff00) >> 8);
-            float bb = (float)(bmpColor & 0xff);
-            
-            unsigned char r = (unsigned char)((1-alpha)*ar + alpha*br);
-            unsigned char g = (unsigned char)((1-alpha)*ag + alpha*bg);
-            unsigned char b = (unsigned char)((1-alpha)*ab + alpha*bb);
-            
-            unsigned int pixel_color = b | (g << 8) | (r << 16);
-            *pixel++ = pixel_color;
+            span = img.spans->spans.data() + img.spans->rows[sy];
+            spanEnd = img.spans->spans.data() + img.spans->rows[sy+1];
+        }
+
+        for (; span < spanEnd; span++)
+        {
+            if (span->type == kSpanSkip) continue;
+
+            // Texels of the span inside the sub-rect, relative to its first sampled texel
+            int k0 = max(span->start, srcX) - srcX;
+            int k1 = min(span->end, srcX+srcW) - srcX;
+            if (k0 >= k1) continue;
+            if (reversed)
+            {
+                int k = k0;
+                k0 = srcW-k1;
+                k1 = srcW-k;
+            }
+
+            int i0 = FirstSampleAt(k0, fx0, stepX, count);
+            int i1 = FirstSampleAt(k1, fx0, stepX, count);
+            int n = i1-i0;
+            if (n <= 0) continue;
+
+            int fx = fx0 + i0*stepX;
+            if (unscaled && span->type == kSpanCopy)
+                CopyRowOpaque(row+i0, src + (fx >> 16), n);
+            else if (unscaled)
+                blend(row+i0, src + (fx >> 16), n);
+            else if (span->type == kSpanCopy)
+                SampleRow(row+i0, src, fx, stepX, n, reversed, 0xffffff);
+            else 
+            {
+                SampleRow(scanline, src, fx, stepX, n, reversed, 0xffffffff);
+                blend(row+i0, scanline, n);
+            }
         }
-        row += stride;
-        pixel = row;
     }
 }
 
+void Renderer::DrawLetter(Font *font, int index, Vector2i pos, Vector2i hSize)
+{
+    BlitScaled(font->bitmap, index*font->lWidth, 0, font->lWidth, font->lHeight, 
+        pos.x-hSize.x-_cam.x, pos.y-hSize.y-_cam.y, 
+        pos.x+hSize.x-_cam.x, pos.y+hSize.y-_cam.y, false);
+}
+
 void Renderer::PrintText(Text text)
 {
+    PROFILE_ZONE("Renderer::PrintText");
     int fx = text.pos.x;
 
     int ox = text.pos.x;
@@ -177,62 +401,15 @@ void Renderer::PrintText(Text text)
 
 void Renderer::DrawSprite(Bitmap img, Vector2i sprite_size, Vector2i pos, Vector2i hSize, Vector2i offset, bool reversed)
 {
-    int x0 = (int)(pos.x-hSize.x)-_cam.x;
-    int y0 = (int)(pos.y-hSize.y)-_cam.y;
-    int x1 = (int)(pos.x+hSize.x)-_cam.x;
-    int y1 = (int)(pos.y+hSize.y)-_cam.y;
-
-    float xRange = (float)(x1 - x0);
-    float yRange = (float)(y1 - y0);
-
-    int x0Clamped = Clamp(0, x0, _buffer->width);
-    int y0Clamped = Clamp(0, y0, _buffer->height);
-    x1 = Clamp(0, x1, _buffer->width);
-    y1 = Clamp(0, y1, _buffer->height);
-
-    unsigned int *row = _buffer->pixels + x0Clamped + _buffer->width*y0Clamped;
-    unsigned int *pixel = row;
-    int stride = _buffer->width;
-    for (int y = y0Clamped; y < y1; y++) 
-    {  
-        float v = ((float)y-y0Clamped)/yRange + (float)(y0Clamped-y0)/yRange;
-        int uvStride = (int)((v+(float)offset.y)*(float)sprite_size.y)*img.width;
-        unsigned int *src_pixels = img.pixels + uvStride;
-        for (int x = x0Clamped; x < x1; x++) 
-        {
-            float u = ((float)x-x0Clamped)/xRange + (float)(x0Clamped-x0)/xRange; 
-            int px = 0;
-            if (!reversed)
-                px = (int)(u*(float)sprite_size.x)+offset.x*sprite_size.x;
-            else 
-                px = (offset.x+1)*sprite_size.x-(int)(u*(float)sprite_size.x)-1;
-            
-            unsigned int bmpColor = *(src_pixels + px);
-            
-            float alpha = (float)((bmpColor & 0xff000000) >> 24)/255.f;
-            
-            float ar = (float)((*pixel & 0xff0000) >> 16);
-            float ag = (float)((*pixel & 0xff00) >> 8);
-            float ab = (float)(*pixel & 0xff);
-            
-            float br = (float)((bmpColor & 0xff0000) >> 16);
-            float bg = (float)((bmpColor & 0xff00) >> 8);
-            float bb = (float)(bmpColor & 0xff);
-            
-            unsigned char r = (unsigned char)((1-alpha)*ar + alpha*br);
-            unsigned char g = (unsigned char)((1-alpha)*ag + alpha*bg);
-            unsigned char b = (unsigned char)((1-alpha)*ab + alpha*bb);
-            
-            unsigned int pixel_color = b | (g << 8) | (r << 16);
-            *pixel++ = pixel_color;
-        }
-        row += stride;
-        pixel = row;
-    }
+    PROFILE_ZONE("Renderer::DrawSprite");
+    BlitScaled(img, offset.x*sprite_size.x, offset.y*sprite_size.y, sprite_size.x, sprite_size.y, 
+        pos.x-hSize.x-_cam.x, pos.y-hSize.y-_cam.y, 
+        pos.x+hSize.x-_cam.x, pos.y+hSize.y-_cam.y, reversed);
 }
 
 void Renderer::Update(float dt)
 {
+    PROFILE_ZONE("Renderer::Update");
     if (!(_desiredCam.x == _cam.x && _desiredCam.y == _cam.y))
     {
         _transitionTime += dt/2;
@@ -243,17 +420,356 @@ void Renderer::Update(float dt)
     else
         _transitionTime = 0;
 
-    for (const Rect &r : rectsToDraw)
-        DrawRect(r.pos-_cam, r.hSize, r.color);
-    for (auto const &o : objectsToDraw)
+    auto start = std::chrono::steady_clock::now();
+    BuildSortKeys();
+    SortKeys();
+
+    // Keys are sorted by layer, so each layer is timed from its first key to the next layer's
+    int timedLayer = kLayerRects;
+    for (unsigned long long key : _keys)
     {
-        o->IncrementFrameTime(dt);
-        o->Draw(this);
+        int layer = (int)(key >> 61);
+        int index = (int)(key & (kMaxSortedDraws-1));
+        if (layer != timedLayer)
+        {
+            ((timedLayer == kLayerText) ? _stats.text : _stats.sprites) += ElapsedMs(start);
+            start = std::chrono::steady_clock::now();
+            timedLayer = layer;
+        }
+
+        switch (layer)
+        {
+            case kLayerRects:
+            {
+                const Rect &r = _rects[index];
+                DrawRect(r.pos-_cam, r.hSize, r.color);
+            } break;
+
+            case kLayerLastObjects:
+            case kLayerObjects:
+            {
+                _objects[index]->IncrementFrameTime(dt);
+                _objects[index]->Draw(this);
+            } break;
+
+            case kLayerText: PrintText(_texts[index]); break;
+            case kLayerUi: _ui[index]->Draw(this); break;
+        }
     }
-    for (const Text &t : textToDraw)
-        PrintText(t);
-    for (auto const &u : uiToDraw)
-        u->Draw(this);
+
+    ((timedLayer == kLayerText) ? _stats.text : _stats.sprites) += ElapsedMs(start);
+}
+
+void Renderer::BuildSortKeys()
+{
+    _keys.clear();
+    // Materials only group draws within a frame, so they are numbered again every frame:
+    // every image in the table is still loaded, and the same draws get the same numbers
+    _materials.clear();
+
+    int rectCount = min((int)_rects.size(), kMaxSortedDraws);
+    for (int i = 0; i < rectCount; i++)
+        _keys.push_back(((unsigned long long)kLayerRects << 61) | i);
+
+    int objectCount = min((int)_objects.size(), kMaxSortedDraws);
+    for (int i = 0; i < objectCount; i++)
+    {
+        const Sprite *o = _objects[i];
+        unsigned long long layer = (o->lastLayer) ? kLayerLastObjects : kLayerObjects;
+
+        // Higher objects are further away, so depth grows as the position on ground decreases
+        unsigned int depth = ~((unsigned int)o->GetPosOnGround() ^ 0x80000000u);
+        // Materials are numbered in the order images are first drawn this frame.
+        // Past 512 images, different images share a material and are only less well grouped
+        auto found = _materials.emplace(o->GetImage().pixels, (unsigned int)_materials.size()).first;
+        unsigned int material = found->second & kMaterialMask;
+
+        _keys.push_back((layer << 61) | ((unsigned long long)depth << 29) | 
+            ((unsigned long long)material << 20) | i);
+    }
+
+    int textCount = min((int)_texts.size(), kMaxSortedDraws);
+    for (int i = 0; i < textCount; i++)
+        _keys.push_back(((unsigned long long)kLayerText << 61) | i);
+    int uiCount = min((int)_ui.size(), kMaxSortedDraws);
+    for (int i = 0; i < uiCount; i++)
+        _keys.push_back(((unsigned long long)kLayerUi << 61) | i);
+}
+
+void Renderer::SortKeys()
+{
+    int n = (int)_keys.size();
+    if ((int)_sortBuffer.size() < n) _sortBuffer.resize(n);
+
+    unsigned long long *src = _keys.data();
+    unsigned long long *dst = _sortBuffer.data();
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        int count[256] = {0};
+        for (int i = 0; i < n; i++)
+            count[(src[i] >> shift) & 0xff]++;
+
+        // Every key has the same byte, so this pass would not move anything
+        if (n == 0 || count[(src[0] >> shift) & 0xff] == n) continue;
+
+        int offset = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            int c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (int i = 0; i < n; i++)
+            dst[count[(src[i] >> shift) & 0xff]++] = src[i];
+        SWAP(src, dst);
+    }
+
+    if (src != _keys.data())
+        memcpy(_keys.data(), src, n*sizeof(unsigned long long));
+}
+
+void Renderer::AddObject(Sprite *object)
+{
+    _objects.push_back(object);
+}
+
+void Renderer::AddRect(Rect rect)
+{
+    _rects.push_back(rect);
+}
+
+void Renderer::AddText(Text text)
+{
+    _texts.push_back(text);
+}
+
+void Renderer::AddUi(Sprite *ui)
+{
+    _ui.push_back(ui);
+}
+
+void Renderer::RemoveSprite(Sprite *sprite)
+{
+    _objects.erase(std::remove(_objects.begin(), _objects.end(), sprite), _objects.end());
+    _ui.erase(std::remove(_ui.begin(), _ui.end(), sprite), _ui.end());
+}
+
+void Renderer::ClearDrawLists()
+{
+    _objects.clear();
+    _rects.clear();
+    _texts.clear();
+    _ui.clear();
+}
+
+void Renderer::EnableBinning(int threadCount)
+{
+    Flush();
+    delete _pool;
+    threadCount = max(1, threadCount);
+    _pool = new ThreadPool(threadCount);
+    _scanlines.resize(threadCount);
+    _binning = true;
+}
+
+void Renderer::DisableBinning()
+{
+    Flush();
+    delete _pool;
+    _pool = nullptr;
+    _binning = false;
+}
+
+ThreadPool *Renderer::GetThreadPool() const
+{
+    return _pool;
+}
+
+void Renderer::EnablePipelining(bool enabled)
+{
+    Flush();
+    _pipelined = enabled;
+    _fullRedraw = true;
+}
+
+void Renderer::Flush()
+{
+    if (!_binning || _pipelined) return;
+    Rasterize(_commands, _buffer);
+    _commands.clear();
+}
+
+void Renderer::TakeCommands(std::vector<DrawCommand> &commands)
+{
+    commands.clear();
+    commands.swap(_commands);
+}
+
+void Renderer::Rasterize(const std::vector<DrawCommand> &commands, WinBuffer *buffer)
+{
+    PROFILE_ZONE("Renderer::Rasterize");
+    _target = buffer;
+
+    int tilesX = (_target->width + kTileWidth-1)/kTileWidth;
+    int tilesY = (_target->height + kTileHeight-1)/kTileHeight;
+    int tileCount = tilesX*tilesY;
+    if ((int)_bins.size() < tileCount) _bins.resize(tileCount);
+    for (int i = 0; i < tileCount; i++)
+        _bins[i].clear();
+
+    // Commands are binned in submission order, which keeps them back to front in each tile
+    for (int i = 0; i < (int)commands.size(); i++)
+    {
+        const ScreenRect &r = commands[i].rect;
+        int x0 = max(0, r.x0), x1 = min(_target->width, r.x1);
+        int y0 = max(0, r.y0), y1 = min(_target->height, r.y1);
+        if (x0 >= x1 || y0 >= y1) continue;
+
+        for (int ty = y0/kTileHeight; ty <= (y1-1)/kTileHeight; ty++)
+        {
+            for (int tx = x0/kTileWidth; tx <= (x1-1)/kTileWidth; tx++)
+                _bins[ty*tilesX+tx].push_back(i);
+        }
+    }
+
+    for (std::vector<unsigned int> &scanline : _scanlines)
+    {
+        if ((int)scanline.size() < kTileWidth) scanline.resize(kTileWidth);
+    }
+
+    _pool->ParallelFor(tileCount, [&](int tile, int thread)
+    {
+        PROFILE_ZONE("Raster tile");
+        int tx = tile%tilesX;
+        int ty = tile/tilesX;
+        ScreenRect clip = {
+            tx*kTileWidth, ty*kTileHeight, 
+            min(_target->width, (tx+1)*kTileWidth), min(_target->height, (ty+1)*kTileHeight)
+        };
+
+        unsigned int *scanline = _scanlines[thread].data();
+        for (int c : _bins[tile])
+            Raster(commands[c], clip, scanline);
+    });
+}
+
+static const int kMaxDirtyRects = 32;       // above this, dirty rects are merged into their bounding box
+
+/* Returns the area of a rect */
+static long long Area(const ScreenRect &r)
+{
+    return (long long)(r.x1-r.x0)*(r.y1-r.y0);
+}
+
+/* Returns the bounding box of two rects */
+static ScreenRect Union(const ScreenRect &a, const ScreenRect &b)
+{
+    return {min(a.x0, b.x0), min(a.y0, b.y0), max(a.x1, b.x1), max(a.y1, b.y1)};
+}
+
+/**
+ * Merges rects that overlap, or whose bounding box is barely bigger than both of them
+ * Keeps at most kMaxDirtyRects rects
+ */
+static void MergeRects(std::vector<ScreenRect> &rects)
+{
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (int i = 0; i < (int)rects.size(); i++)
+        {
+            for (int j = i+1; j < (int)rects.size(); j++)
+            {
+                ScreenRect u = Union(rects[i], rects[j]);
+                if (Area(u)*4 > (Area(rects[i]) + Area(rects[j]))*5) continue;
+
+                rects[i] = u;
+                rects[j] = rects.back();
+                rects.pop_back();
+                merged = true;
+                j = i;
+            }
+        }
+    }
+
+    if ((int)rects.size() > kMaxDirtyRects)
+    {
+        ScreenRect box = rects[0];
+        for (const ScreenRect &r : rects)
+            box = Union(box, r);
+        rects.assign(1, box);
+    }
+}
+
+void Renderer::EnableDamageTracking(bool enabled)
+{
+    _trackDamage = enabled;
+    _fullRedraw = true;
+    _damage.clear();
+    _lastDamage.clear();
+}
+
+void Renderer::SetDamageOverlay(bool enabled)
+{
+    _damageOverlay = enabled;
+}
+
+void Renderer::EndFrame()
+{
+    auto start = std::chrono::steady_clock::now();
+    Flush();
+    _stats.raster += ElapsedMs(start);
+
+    _dirty.clear();
+    if (!_trackDamage || _pipelined || _fullRedraw)
+        _dirty.push_back({0, 0, _buffer->width, _buffer->height});
+    else
+    {
+        // What was drawn last frame got erased, and what is drawn this frame is new
+        _dirty = _lastDamage;
+        _dirty.insert(_dirty.end(), _damage.begin(), _damage.end());
+        MergeRects(_dirty);
+    }
+    MergeRects(_damage);
+
+    if (_damageOverlay)
+    {
+        DrawCommand command = {kCommandRect};
+        command.color = 0xFF00FF;
+        for (const ScreenRect &r : _dirty)
+        {
+            ScreenRect edges[4] = {
+                {r.x0, r.y0, r.x1, r.y0+1}, {r.x0, r.y1-1, r.x1, r.y1},
+                {r.x0, r.y0, r.x0+1, r.y1}, {r.x1-1, r.y0, r.x1, r.y1}
+            };
+            for (const ScreenRect &edge : edges)
+            {
+                command.rect = edge;
+                Submit(command);
+            }
+        }
+        start = std::chrono::steady_clock::now();
+        Flush();
+        _stats.raster += ElapsedMs(start);
+        MergeRects(_damage);
+    }
+
+    _lastDamage.swap(_damage);
+    _damage.clear();
+    _fullRedraw = false;
+    _lastStats = _stats;
+    _stats = {};
+}
+
+const std::vector<ScreenRect> &Renderer::GetDirtyRects() const
+{
+    return _dirty;
+}
+
+const RendererStats &Renderer::GetStats() const
+{
+    return _lastStats;
 }
 
 void Renderer::TranslateCamera(Vector2i u)
@@ -275,15 +791,3 @@ int Renderer::GetBufferHeight() const
 {
     return _buffer->height;
 }
-
-void Renderer::SortObjects()
-{
-    std::sort(objectsToDraw.begin(), objectsToDraw.end(), []
-        (const Sprite *lhs, const Sprite *rhs)
-        {
-            if (lhs->lastLayer) return true;
-            if (rhs->lastLayer) return false;
-            return lhs->GetPosOnGround() > rhs->GetPosOnGround();
-        }
-    );
-}
\ No newline at end of file
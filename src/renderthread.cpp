@@ -0,0 +1,139 @@
+/**
+ * @file renderthread.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the RenderThread class's implementation
+ */
+
+#include "RenderThread.hpp"
+#include "Profiler.hpp"
+#include <chrono>
+
+static const int kIdleSpins = 64;           // yields before the render thread starts sleeping when idle
+
+/* Waits a little while the render thread has nothing to do: yields first, then sleeps */
+static void Idle(int &spins)
+{
+    if (spins++ < kIdleSpins)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+/* Resizes the buffer of a render target */
+static void ResizeTarget(RenderTarget &target, int width, int height)
+{
+    target.pixels.assign((size_t)width*height, 0);
+    target.buffer = {};
+    target.buffer.width = width;
+    target.buffer.height = height;
+    target.buffer.pixels = target.pixels.data();
+#ifdef _WIN32
+    target.buffer.info.bmiHeader.biSize = sizeof(target.buffer.info.bmiHeader);
+    target.buffer.info.bmiHeader.biWidth = width;
+    target.buffer.info.bmiHeader.biHeight = height;
+    target.buffer.info.bmiHeader.biPlanes = 1;
+    target.buffer.info.bmiHeader.biBitCount = 32;
+    target.buffer.info.bmiHeader.biCompression = BI_RGB;
+#endif
+}
+
+RenderThread::RenderThread(Renderer *renderer, int bufferCount, bool dropFrames)
+    : _renderer(renderer), _frames(3), _targets(bufferCount), _running(true), _rasterTime(0),
+    _dropFrames(dropFrames)
+{
+    _renderer->EnablePipelining(true);
+    _thread = std::thread(&RenderThread::Run, this);
+}
+
+RenderThread::~RenderThread()
+{
+    _running.store(false, std::memory_order_release);
+    _thread.join();
+    _renderer->EnablePipelining(false);
+}
+
+void RenderThread::Run()
+{
+    int spins = 0;
+    while (_running.load(std::memory_order_acquire))
+    {
+        RecordedFrame *frame = _frames.TakeLatest();
+        if (!frame)
+        {
+            Idle(spins);
+            continue;
+        }
+
+        // With 2 buffers, the window must take the last completed one before the other is free.
+        // When frames aren't dropped, it must take it before the next one is completed in any case
+        RenderTarget *target = nullptr;
+        while (!target && _running.load(std::memory_order_acquire))
+        {
+            if (_dropFrames || _targets.IsLatestTaken())
+                target = _targets.BeginWrite();
+            if (!target)
+                Idle(spins);
+        }
+        if (!target)
+            break;
+        spins = 0;
+
+        PROFILE_ZONE("RenderThread::Frame");
+        auto start = std::chrono::steady_clock::now();
+        if (target->buffer.width != frame->width || target->buffer.height != frame->height)
+            ResizeTarget(*target, frame->width, frame->height);
+        _renderer->Rasterize(frame->commands, &target->buffer);
+        _targets.EndWrite();
+
+        auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-start);
+        _rasterTime.fetch_add(time.count(), std::memory_order_relaxed);
+    }
+}
+
+void RenderThread::Submit()
+{
+    int spins = 0;
+    while (!_dropFrames && !_frames.IsLatestTaken())
+        Idle(spins);
+
+    // There are 3 frame slots, so one is always free
+    RecordedFrame *frame = _frames.BeginWrite();
+    _renderer->TakeCommands(frame->commands);
+    frame->width = _renderer->GetBufferWidth();
+    frame->height = _renderer->GetBufferHeight();
+    _frames.EndWrite();
+}
+
+const WinBuffer *RenderThread::TakeCompletedBuffer()
+{
+    int spins = 0;
+    while (!_dropFrames && _targets.GetPublishedCount() < _frames.GetPublishedCount()-1)
+        Idle(spins);
+
+    RenderTarget *target = _targets.TakeLatest();
+    if (!target)
+        return nullptr;
+    _presented++;
+    return &target->buffer;
+}
+
+RenderThreadStats RenderThread::GetStats() const
+{
+    RenderThreadStats stats = {};
+    stats.submitted = _frames.GetPublishedCount();
+    stats.dropped = _frames.GetDroppedCount();
+    stats.rasterized = _targets.GetPublishedCount();
+    stats.presented = _presented;
+    if (stats.rasterized > 0)
+        stats.raster = _rasterTime.load(std::memory_order_relaxed)/1000.f/stats.rasterized;
+    return stats;
+}
+
+void RenderThread::Report(FILE *file) const
+{
+    RenderThreadStats stats = GetStats();
+    fprintf(file, "%d frames submitted, %d dropped, %d rasterized in %.3f ms on average, %d presented\n",
+        stats.submitted, stats.dropped, stats.rasterized, stats.raster, stats.presented);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file spatialhash.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the SpatialHash class's implementation
+ */
+
+#include "SpatialHash.hpp"
+#include <algorithm>
+
+SpatialHash::SpatialHash(float cellSize, int bucketCount)
+    : _cellSize(cellSize)
+{
+    int size = 1;
+    while (size < bucketCount)
+        size *= 2;
+    _buckets.assign(size, -1);
+}
+
+int SpatialHash::GetBucket(int cellX, int cellY) const
+{
+    unsigned int hash = (unsigned int)cellX*73856093u ^ (unsigned int)cellY*19349663u;
+    return (int)(hash & (unsigned int)(_buckets.size()-1));
+}
+
+void SpatialHash::GetCells(Vector2f pos, Vector2f hSize, int &xmin, int &ymin, int &xmax, int &ymax) const
+{
+    xmin = (int)floorf((pos.x-hSize.x)/_cellSize);
+    ymin = (int)floorf((pos.y-hSize.y)/_cellSize);
+    xmax = (int)floorf((pos.x+hSize.x)/_cellSize);
+    ymax = (int)floorf((pos.y+hSize.y)/_cellSize);
+}
+
+void SpatialHash::Clear()
+{
+    std::fill(_buckets.begin(), _buckets.end(), -1);
+    _entries.clear();
+}
+
+void SpatialHash::Insert(int id, Vector2f pos, Vector2f hSize)
+{
+    if (id >= (int)_marks.size())
+        _marks.resize(id+1, 0);
+
+    int xmin, ymin, xmax, ymax;
+    GetCells(pos, hSize, xmin, ymin, xmax, ymax);
+    for (int y = ymin; y <= ymax; y++)
+    {
+        for (int x = xmin; x <= xmax; x++)
+        {
+            int bucket = GetBucket(x, y);
+            _entries.push_back({id, _buckets[bucket]});
+            _buckets[bucket] = (int)_entries.size()-1;
+        }
+    }
+}
+
+void SpatialHash::Query(Vector2f pos, Vector2f hSize, std::vector<int> &ids)
+{
+    // Ids are marked with the query number the first time they are found
+    if (++_query == 0)
+    {
+        std::fill(_marks.begin(), _marks.end(), 0);
+        _query = 1;
+    }
+
+    int xmin, ymin, xmax, ymax;
+    GetCells(pos, hSize, xmin, ymin, xmax, ymax);
+    for (int y = ymin; y <= ymax; y++)
+    {
+        for (int x = xmin; x <= xmax; x++)
+        {
+            for (int e = _buckets[GetBucket(x, y)]; e >= 0; e = _entries[e].next)
+            {
+                int id = _entries[e].id;
+                if (_marks[id] != _query)
+                {
+                    _marks[id] = _query;
+                    ids.push_back(id);
+                }
+            }
+        }
+    }
+}
@@ -105,7 +105,7 @@ void AnimatedSprite::Draw(Renderer *r)
         _size*_scale, {0, 0}, _reversed);
 }
 
-Animation AnimatedSprite::GetCurrentAnimation()
+const Animation &AnimatedSprite::GetCurrentAnimation() const
 {
     return _animations.at(_animationIndex);
 }
@@ -168,11 +168,11 @@ Tilemap::Tilemap(Vector2i pos, float scale, SpriteSheet sprites, std::vector<int
 
 void Tilemap::Draw(Renderer *r)
 {
+    Vector2i half_size = _size*_scale;
     for (int y = 0; y < _mapSize.y; y++)
     {
         for (int x = 0; x < _mapSize.x; x++)
         {
-            Vector2i half_size = _size*_scale;
             Vector2i offset = {half_size.x*(1/2+x*2), half_size.y*(1/2+y*2)};
             if (_map[y*_mapSize.x+x] != -1)
                 r->DrawSprite(_sprites.sheet, _size, _position+offset, half_size, 
@@ -0,0 +1,116 @@
+/**
+ * @file texturepack.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the TexturePack class's implementation
+ */
+
+#include "TexturePack.hpp"
+#include <string.h>
+
+/* Returns true if the spans of a packed image stay inside it */
+static bool ValidSpans(const SpanTable &table, int width)
+{
+    if (table.rows.front() != 0 || table.rows.back() != (int)table.spans.size())
+        return false;
+    for (int y = 0; y+1 < (int)table.rows.size(); y++)
+    {
+        if (table.rows[y] > table.rows[y+1])
+            return false;
+    }
+    for (const PixelSpan &span : table.spans)
+    {
+        if (span.start < 0 || span.start >= span.end || span.end > width)
+            return false;
+    }
+    return true;
+}
+
+TexturePack::TexturePack()
+{
+}
+
+TexturePack::~TexturePack()
+{
+    Close();
+}
+
+bool TexturePack::Open(const char *filePath)
+{
+    Close();
+    _file = MapFile(filePath);
+    if (!_file.data)
+        return false;
+
+    unsigned long long fileSize = (unsigned long long)_file.size;
+    const PackHeader *header = (const PackHeader *)_file.data;
+    if (fileSize < sizeof(PackHeader) || header->magic != kPackMagic || header->version != kPackVersion ||
+        header->imageCount > (fileSize - sizeof(PackHeader))/sizeof(PackEntry))
+    {
+        Close();
+        return false;
+    }
+
+    const PackEntry *entries = (const PackEntry *)(header+1);
+    for (unsigned int i = 0; i < header->imageCount; i++)
+    {
+        const PackEntry &entry = entries[i];
+        unsigned long long pixelsSize = (unsigned long long)entry.width*entry.height*sizeof(unsigned int);
+        unsigned long long rowsSize = ((unsigned long long)entry.height+1)*sizeof(int);
+        unsigned long long spansSize = (unsigned long long)entry.spanCount*sizeof(PixelSpan);
+        if (entry.width <= 0 || entry.height <= 0 || entry.dataOffset % kPackAlignment ||
+            entry.dataOffset > fileSize || pixelsSize+rowsSize+spansSize > fileSize-entry.dataOffset ||
+            !memchr(entry.path, 0, sizeof(entry.path)))
+        {
+            Close();
+            return false;
+        }
+
+        // Only the spans are copied, pixels are used straight from the mapping
+        const unsigned char *data = _file.data + entry.dataOffset;
+        const int *rows = (const int *)(data + pixelsSize);
+        const PixelSpan *spans = (const PixelSpan *)(data + pixelsSize + rowsSize);
+        SpanTable *table = new SpanTable;
+        table->rows.assign(rows, rows + entry.height+1);
+        table->spans.assign(spans, spans + entry.spanCount);
+        _spans.push_back(table);
+        if (!ValidSpans(*table, entry.width))
+        {
+            Close();
+            return false;
+        }
+
+        Bitmap image = {0};
+        image.width = entry.width;
+        image.height = entry.height;
+        image.pixels = (unsigned int *)data;
+        image.pitch = entry.width;
+        image.spans = table;
+        image.premultiplied = (entry.flags & kPackPremultiplied) != 0;
+        _images[entry.path] = image;
+    }
+    return true;
+}
+
+void TexturePack::Close()
+{
+    for (SpanTable *spans : _spans)
+        delete spans;
+    _spans.clear();
+    _images.clear();
+    UnmapFile(_file);
+}
+
+Bitmap TexturePack::Find(const char *path) const
+{
+    auto found = _images.find(path);
+    if (found == _images.end())
+        return {0};
+    return found->second;
+}
+
+int TexturePack::GetImageCount() const
+{
+    return (int)_images.size();
+}
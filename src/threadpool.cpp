@@ -0,0 +1,113 @@
+/**
+ * @file threadpool.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * This file defines the ThreadPool class's implementation
+ */
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int threadCount)
+    : _nextIndex(0)
+{
+    for (int i = 1; i < threadCount; i++)
+        _workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (std::thread &t : _workers)
+        t.join();
+}
+
+void ThreadPool::WorkerLoop(int threadIndex)
+{
+    unsigned int generation = 0;
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&] { return _stopping || _generation != generation || !_tasks.empty(); });
+            if (_stopping && _tasks.empty()) return;
+
+            if (_generation == generation)
+            {
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            else generation = _generation;
+        }
+
+        if (task)
+        {
+            task();
+            continue;
+        }
+
+        RunJobs(threadIndex);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_busyWorkers == 0)
+            _done.notify_one();
+    }
+}
+
+void ThreadPool::RunJobs(int threadIndex)
+{
+    for (int i = _nextIndex++; i < _jobCount; i = _nextIndex++)
+        _job(i, threadIndex);
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int, int)> &job)
+{
+    if (count <= 0) return;
+    if (_workers.empty() || count == 1)
+    {
+        for (int i = 0; i < count; i++)
+            job(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = job;
+        _jobCount = count;
+        _nextIndex = 0;
+        _busyWorkers = (int)_workers.size();
+        _generation++;
+    }
+    _wake.notify_all();
+
+    RunJobs(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [&] { return _busyWorkers == 0; });
+    _job = nullptr;
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    if (_workers.empty())
+    {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _wake.notify_one();
+}
+
+int ThreadPool::GetThreadCount() const
+{
+    return (int)_workers.size()+1;
+}
@@ -7,14 +7,15 @@
  */
 
 #include "Window.hpp"
-#include <timeapi.h>
+#include "Profiler.hpp"
+#ifdef _WIN32
 #include <sstream>
 
 HWND Window::_window;
 bool Window::_running = true;
 bool Window::_active = true;
-float Window::_freqCounter;
 WinBuffer Window::_buffer;
+const WinBuffer *Window::_presented = nullptr;
 unsigned int Window::_backgroundColor = 0x000000;
 
 Window::Window(const char *name, int width, int height, HINSTANCE instance)
@@ -51,11 +52,6 @@ Window::Window(const char *name, int width, int height, HINSTANCE instance)
     _buffer.info.bmiHeader.biPlanes = 1;
     _buffer.info.bmiHeader.biBitCount = 32;
     _buffer.info.bmiHeader.biCompression = BI_RGB;
-
-    QueryPerformanceCounter(&_lastCounter);
-    LARGE_INTEGER freq_counter_large;
-    QueryPerformanceFrequency(&freq_counter_large);
-    _freqCounter = (float)freq_counter_large.QuadPart;
 }
 
 Window::~Window()
@@ -91,9 +87,10 @@ LRESULT CALLBACK Window::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM
             FillRect(deviceContext, &rect, brush);
             DeleteObject(brush);
 
-            StretchDIBits(deviceContext, 0, 0, _buffer.width, _buffer.height, 
-                0, 0, _buffer.width, _buffer.height, 
-                _buffer.pixels, &_buffer.info, DIB_RGB_COLORS, SRCCOPY);
+            const WinBuffer &buffer = (_presented) ? *_presented : _buffer;
+            StretchDIBits(deviceContext, 0, 0, buffer.width, buffer.height, 
+                0, 0, buffer.width, buffer.height, 
+                buffer.pixels, &buffer.info, DIB_RGB_COLORS, SRCCOPY);
 
             EndPaint(_window, &paint);
         } return 0;
@@ -169,27 +166,56 @@ void Window::HandleMessages()
 
 void Window::ProcessFrame()
 {
-    RECT rect;
-    GetClientRect(_window, &rect);
-    int width = rect.right - rect.left;
-    int height = rect.bottom - rect.top;
+    ProcessFrame({{0, 0, _buffer.width, _buffer.height}});
+}
 
-    StretchDIBits(_deviceContext, 0, 0, width, height, 
-        0, 0, _buffer.width, _buffer.height, 
-        _buffer.pixels, &_buffer.info, DIB_RGB_COLORS, SRCCOPY);
+void Window::ProcessFrame(const std::vector<ScreenRect> &dirtyRects)
+{
+    PROFILE_ZONE("Window::ProcessFrame");
+    Present(_buffer, dirtyRects);
 
-    float ft = min(.1f, GetElapsedTime());
-    int sleepTime = (int)(1000.f * (_targetFt - ft));
+    float ft = _pacer.Wait();
+    _lastFt = (_active) ? ft : 0.f;
+}
 
-    timeBeginPeriod(1);
-    if (sleepTime > 1)
-        Sleep(sleepTime-1);
-    timeEndPeriod(1);
+void Window::ProcessFrame(const WinBuffer *buffer)
+{
+    PROFILE_ZONE("Window::ProcessFrame");
+    if (buffer)
+    {
+        _presented = buffer;
+        Present(*buffer, {{0, 0, buffer->width, buffer->height}});
+    }
 
-    ft = GetElapsedTime();
+    float ft = _pacer.Wait();
     _lastFt = (_active) ? ft : 0.f;
-    
-    QueryPerformanceCounter(&_lastCounter);
+}
+
+void Window::StopPresenting()
+{
+    _presented = nullptr;
+}
+
+void Window::Present(const WinBuffer &buffer, const std::vector<ScreenRect> &dirtyRects)
+{
+    RECT rect;
+    GetClientRect(_window, &rect);
+    int width = rect.right - rect.left;
+    int height = rect.bottom - rect.top;
+
+    // The buffer is a bottom-up DIB: its rows start at the bottom of the window
+    for (int i = 0; i < (int)dirtyRects.size() && buffer.width > 0 && buffer.height > 0; i++)
+    {
+        const ScreenRect &r = dirtyRects[i];
+        int x0 = r.x0*width/buffer.width;
+        int x1 = (r.x1*width + buffer.width-1)/buffer.width;
+        int y0 = r.y0*height/buffer.height;
+        int y1 = (r.y1*height + buffer.height-1)/buffer.height;
+
+        StretchDIBits(_deviceContext, x0, height-y1, x1-x0, y1-y0, 
+            r.x0, r.y0, r.x1-r.x0, r.y1-r.y0, 
+            buffer.pixels, &buffer.info, DIB_RGB_COLORS, SRCCOPY);
+    }
 }
 
 void Window::SetBackgroundColor(unsigned int color) const
@@ -207,13 +233,6 @@ HWND *Window::GetWindow() const
     return &_window;
 }
 
-float Window::GetElapsedTime() const
-{
-    LARGE_INTEGER currentCounter;
-    QueryPerformanceCounter(&currentCounter);
-    return (float)(currentCounter.QuadPart - _lastCounter.QuadPart) / _freqCounter;
-}
-
 float Window::GetFt() const
 {
     return _lastFt;
@@ -222,4 +241,10 @@ float Window::GetFt() const
 WinBuffer *Window::GetBuffer() const
 {
     return &_buffer;
-}
\ No newline at end of file
+}
+
+FramePacer &Window::GetPacer()
+{
+    return _pacer;
+}
+#endif
\ No newline at end of file
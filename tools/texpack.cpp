@@ -0,0 +1,115 @@
+/**
+ * @file texpack.cpp
+ * @author Julie Fiadino
+ * @copyright Copyright 2021 (C) Julie Fiadino
+ *
+ * Texture pack builder
+ * Decodes every PNG of a folder and its subfolders, and writes them to a pack file
+ * ready to be mapped by TexturePack. See TexturePack.hpp for the format
+ *
+ * Usage: texpack [--premultiply] output.pack folder
+ */
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "TexturePack.hpp"
+#include "FileWriter.hpp"
+
+/* Returns the image paths of a folder and its subfolders, with '/' separators and sorted */
+static std::vector<std::string> FindImages(const char *folder)
+{
+    std::vector<std::string> paths;
+    for (const auto &file : std::filesystem::recursive_directory_iterator(folder))
+    {
+        if (file.is_regular_file() && file.path().extension() == ".png")
+            paths.push_back(file.path().generic_string());
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+/* Appends bytes to the pack data */
+static void Append(std::vector<unsigned char> &data, const void *bytes, size_t size)
+{
+    data.insert(data.end(), (const unsigned char *)bytes, (const unsigned char *)bytes + size);
+}
+
+int main(int argc, char **argv)
+{
+    bool premultiply = false;
+    std::vector<const char *> arguments;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--premultiply"))
+            premultiply = true;
+        else
+            arguments.push_back(argv[i]);
+    }
+    if (arguments.size() != 2)
+    {
+        fprintf(stderr, "Usage: texpack [--premultiply] output.pack folder\n");
+        return 1;
+    }
+
+    std::vector<std::string> paths = FindImages(arguments[1]);
+    std::vector<PackEntry> entries;
+    std::vector<unsigned char> data;
+    size_t dataStart = sizeof(PackHeader) + paths.size()*sizeof(PackEntry);
+    for (const std::string &path : paths)
+    {
+        if (path.size() >= sizeof(PackEntry::path))
+        {
+            fprintf(stderr, "Skipped %s: path too long\n", path.c_str());
+            continue;
+        }
+
+        Bitmap image = ReadImage(path.c_str(), premultiply);
+        if (!image.pixels)
+        {
+            fprintf(stderr, "Skipped %s: not a valid image\n", path.c_str());
+            continue;
+        }
+
+        // Each image starts on an aligned offset
+        while ((dataStart + data.size()) % kPackAlignment)
+            data.push_back(0);
+
+        PackEntry entry = {};
+        memcpy(entry.path, path.c_str(), path.size()+1);
+        entry.dataOffset = dataStart + data.size();
+        entry.width = image.width;
+        entry.height = image.height;
+        entry.spanCount = (unsigned int)image.spans->spans.size();
+        entry.flags = premultiply ? kPackPremultiplied : 0;
+        entries.push_back(entry);
+
+        Append(data, image.pixels, (size_t)image.width*image.height*sizeof(unsigned int));
+        Append(data, image.spans->rows.data(), image.spans->rows.size()*sizeof(int));
+        Append(data, image.spans->spans.data(), image.spans->spans.size()*sizeof(PixelSpan));
+        FreeImage(image);
+    }
+
+    // Skipped images leave their entries unused, data offsets stay valid
+    PackHeader header = {kPackMagic, kPackVersion, (unsigned int)entries.size(), 0};
+    entries.resize(paths.size());
+    std::vector<unsigned char> pack;
+    Append(pack, &header, sizeof(header));
+    Append(pack, entries.data(), entries.size()*sizeof(PackEntry));
+    Append(pack, data.data(), data.size());
+
+    FILE *file = OpenFileForWriting(arguments[0]);
+    if (!file || fwrite(pack.data(), 1, pack.size(), file) != pack.size())
+    {
+        fprintf(stderr, "Could not write %s\n", arguments[0]);
+        return 1;
+    }
+    fclose(file);
+
+    printf("Packed %d images in %s, %.1f MB\n", header.imageCount, arguments[0], pack.size()/(1024.f*1024.f));
+    return 0;
+}